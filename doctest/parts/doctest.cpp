@@ -77,9 +77,14 @@ DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
 #include <algorithm>
 #include <iomanip>
 #include <vector>
+#include <deque>
+#include <functional>
 #ifndef DOCTEST_CONFIG_NO_MULTITHREADING
 #include <atomic>
 #include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
 #define DOCTEST_DECLARE_MUTEX(name) std::mutex name;
 #define DOCTEST_DECLARE_STATIC_MUTEX(name) static DOCTEST_DECLARE_MUTEX(name)
 #define DOCTEST_LOCK_MUTEX(name) std::lock_guard<std::mutex> DOCTEST_ANONYMOUS(DOCTEST_ANON_LOCK_)(name);
@@ -98,6 +103,9 @@ DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
 #include <cctype>
 #include <cstdint>
 #include <string>
+#ifdef DOCTEST_CONFIG_FILTER_REGEX
+#include <regex>
+#endif // DOCTEST_CONFIG_FILTER_REGEX
 
 #ifdef DOCTEST_PLATFORM_MAC
 #include <sys/types.h>
@@ -130,8 +138,47 @@ DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
 #include <sys/time.h>
 #include <unistd.h>
 
+#ifndef DOCTEST_PLATFORM_WASI
+#include <sys/resource.h>
+// the resources used by test cases (see --resource-summary) are measured with getrusage()
+#define DOCTEST_RESOURCE_USAGE
+#endif // DOCTEST_PLATFORM_WASI
+
+#if defined(DOCTEST_PLATFORM_LINUX) && defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+// the performance counters of test cases (see --perf-counters) are read with perf_event_open()
+#define DOCTEST_PERF_EVENTS
+#endif // DOCTEST_PLATFORM_LINUX && __linux__
+
 #endif // DOCTEST_PLATFORM_WINDOWS
 
+#ifdef DOCTEST_CONFIG_POSIX_FORK
+#include <cerrno>
+#include <poll.h>
+#include <sys/wait.h>
+#endif // DOCTEST_CONFIG_POSIX_FORK
+
+#ifdef DOCTEST_CONFIG_TRACK_ALLOCATIONS
+#include <cstddef>
+#ifdef __GLIBC__
+#include <cerrno>
+#include <malloc.h>
+#endif // __GLIBC__
+#endif // DOCTEST_CONFIG_TRACK_ALLOCATIONS
+
+#if !defined(DOCTEST_PLATFORM_WINDOWS) && !defined(DOCTEST_PLATFORM_WASI) &&                      \
+        !defined(DOCTEST_CONFIG_NO_MULTITHREADING)
+#include <pthread.h>
+// the watchdog (see --test-timeout) stops the thread of the test case with a signal
+#define DOCTEST_WATCHDOG_SIGNAL
+// and captures its stack with backtrace() unless crash handling is disabled
+#if defined(DOCTEST_CONFIG_POSIX_SIGNALS) && (defined(__GLIBC__) || defined(DOCTEST_PLATFORM_MAC))
+#include <execinfo.h>
+#define DOCTEST_WATCHDOG_BACKTRACE
+#endif // DOCTEST_CONFIG_POSIX_SIGNALS && (__GLIBC__ || DOCTEST_PLATFORM_MAC)
+#endif // !DOCTEST_PLATFORM_WINDOWS && !DOCTEST_PLATFORM_WASI && !DOCTEST_CONFIG_NO_MULTITHREADING
+
 // this is a fix for https://github.com/doctest/doctest/issues/348
 // https://mail.gnome.org/archives/xml/2012-January/msg00000.html
 #if !defined(HAVE_UNISTD_H) && !defined(STDOUT_FILENO)
@@ -162,16 +209,17 @@ DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
 #define DOCTEST_THREAD_LOCAL
 #else // DOCTEST_MSVC
 #define DOCTEST_THREAD_LOCAL thread_local
+#if defined(__GNUC__) && defined(__ELF__)
+// for the ones updated by malloc() (see DOCTEST_CONFIG_TRACK_ALLOCATIONS) - even in a shared object
+// they are accessed without __tls_get_addr() which might call malloc() itself
+#define DOCTEST_THREAD_LOCAL_INITIAL_EXEC __attribute__((tls_model("initial-exec"))) thread_local
+#endif // __GNUC__ && __ELF__
 #endif // DOCTEST_MSVC
 #endif // DOCTEST_THREAD_LOCAL
 
-#ifndef DOCTEST_MULTI_LANE_ATOMICS_THREAD_LANES
-#define DOCTEST_MULTI_LANE_ATOMICS_THREAD_LANES 32
-#endif
-
-#ifndef DOCTEST_MULTI_LANE_ATOMICS_CACHE_LINE_SIZE
-#define DOCTEST_MULTI_LANE_ATOMICS_CACHE_LINE_SIZE 64
-#endif
+#ifndef DOCTEST_THREAD_LOCAL_INITIAL_EXEC
+#define DOCTEST_THREAD_LOCAL_INITIAL_EXEC DOCTEST_THREAD_LOCAL
+#endif // DOCTEST_THREAD_LOCAL_INITIAL_EXEC
 
 #ifdef DOCTEST_CONFIG_NO_UNPREFIXED_OPTIONS
 #define DOCTEST_OPTIONS_PREFIX_DISPLAY DOCTEST_CONFIG_OPTIONS_PREFIX
@@ -179,7 +227,9 @@ DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
 #define DOCTEST_OPTIONS_PREFIX_DISPLAY ""
 #endif
 
-#if defined(WINAPI_FAMILY) && (WINAPI_FAMILY == WINAPI_FAMILY_APP)
+// the per-thread assert counters need a real thread_local
+#if defined(WINAPI_FAMILY) && (WINAPI_FAMILY == WINAPI_FAMILY_APP) ||                              \
+        DOCTEST_MSVC && (DOCTEST_MSVC < DOCTEST_COMPILER(19, 0, 0))
 #define DOCTEST_CONFIG_NO_MULTI_LANE_ATOMICS
 #endif
 
@@ -291,8 +341,12 @@ namespace timer_large_integer
 
 using ticks_t = timer_large_integer::type;
 
-#ifdef DOCTEST_CONFIG_GETCURRENTTICKS
-    ticks_t getCurrentTicks() { return DOCTEST_CONFIG_GETCURRENTTICKS(); }
+// the ticks are nanoseconds from a monotonic clock
+#if defined(DOCTEST_CONFIG_GETCURRENTNANOSECONDS)
+    ticks_t getCurrentTicks() { return DOCTEST_CONFIG_GETCURRENTNANOSECONDS(); }
+#elif defined(DOCTEST_CONFIG_GETCURRENTTICKS)
+    // the older hook returns microseconds
+    ticks_t getCurrentTicks() { return DOCTEST_CONFIG_GETCURRENTTICKS() * 1000; }
 #elif defined(DOCTEST_PLATFORM_WINDOWS)
     ticks_t getCurrentTicks() {
         static LARGE_INTEGER hz = { {0} }, hzo = { {0} };
@@ -302,26 +356,35 @@ using ticks_t = timer_large_integer::type;
         }
         LARGE_INTEGER t;
         QueryPerformanceCounter(&t);
-        return ((t.QuadPart - hzo.QuadPart) * LONGLONG(1000000)) / hz.QuadPart;
+        // split into seconds and a remainder so the multiplication can't overflow
+        const auto ticks = t.QuadPart - hzo.QuadPart;
+        return (ticks / hz.QuadPart) * LONGLONG(1000000000) +
+               ((ticks % hz.QuadPart) * LONGLONG(1000000000)) / hz.QuadPart;
+    }
+#elif defined(CLOCK_MONOTONIC)
+    ticks_t getCurrentTicks() {
+        timespec t;
+#ifdef CLOCK_MONOTONIC_RAW
+        // not subject to adjustments by NTP
+        clock_gettime(CLOCK_MONOTONIC_RAW, &t);
+#else  // CLOCK_MONOTONIC_RAW
+        clock_gettime(CLOCK_MONOTONIC, &t);
+#endif // CLOCK_MONOTONIC_RAW
+        return static_cast<ticks_t>(t.tv_sec) * 1000000000 + static_cast<ticks_t>(t.tv_nsec);
     }
 #else  // DOCTEST_PLATFORM_WINDOWS
     ticks_t getCurrentTicks() {
         timeval t;
         gettimeofday(&t, nullptr);
-        return static_cast<ticks_t>(t.tv_sec) * 1000000 + static_cast<ticks_t>(t.tv_usec);
+        return static_cast<ticks_t>(t.tv_sec) * 1000000000 + static_cast<ticks_t>(t.tv_usec) * 1000;
     }
 #endif // DOCTEST_PLATFORM_WINDOWS
 
     struct Timer
     {
-        void         start() { m_ticks = getCurrentTicks(); }
-        unsigned int getElapsedMicroseconds() const {
-            return static_cast<unsigned int>(getCurrentTicks() - m_ticks);
-        }
-        //unsigned int getElapsedMilliseconds() const {
-        //    return static_cast<unsigned int>(getElapsedMicroseconds() / 1000);
-        //}
-        double getElapsedSeconds() const { return static_cast<double>(getCurrentTicks() - m_ticks) / 1000000.0; }
+        void    start() { m_ticks = getCurrentTicks(); }
+        ticks_t getElapsedNanoseconds() const { return getCurrentTicks() - m_ticks; }
+        double  getElapsedSeconds() const { return static_cast<double>(getElapsedNanoseconds()) / 1e9; }
 
     private:
         ticks_t m_ticks = 0;
@@ -336,115 +399,483 @@ using ticks_t = timer_large_integer::type;
 #endif // DOCTEST_CONFIG_NO_MULTITHREADING
 
 #if defined(DOCTEST_CONFIG_NO_MULTI_LANE_ATOMICS) || defined(DOCTEST_CONFIG_NO_MULTITHREADING)
-    template <typename T>
-    using MultiLaneAtomic = Atomic<T>;
+    // the assert counters of a test case - shared by all threads
+    class AssertCounters
+    {
+        Atomic<int> m_asserts{0};
+        Atomic<int> m_failed{0};
+
+    public:
+        void addAssert() { ++m_asserts; }
+        void addFailedAssert() { ++m_failed; }
+
+        int numAsserts() const { return m_asserts; }
+        int numAssertsFailed() const { return m_failed; }
+
+        void reset(int asserts = 0, int failed = 0) {
+            m_asserts = asserts;
+            m_failed  = failed;
+        }
+    };
 #else // DOCTEST_CONFIG_NO_MULTI_LANE_ATOMICS
-    // Provides a multilane implementation of an atomic variable that supports add, sub, load,
-    // store. Instead of using a single atomic variable, this splits up into multiple ones,
-    // each sitting on a separate cache line. The goal is to provide a speedup when most
-    // operations are modifying. It achieves this with two properties:
-    //
-    // * Multiple atomics are used, so chance of congestion from the same atomic is reduced.
-    // * Each atomic sits on a separate cache line, so false sharing is reduced.
+    // The assert counters of a test case. Each thread which asserts gets its own pair of counters
+    // (a lane) which registers with the test run - only that thread writes to them and it does
+    // so with a relaxed load and store instead of an atomic read-modify-write, so the hot path of
+    // asserts doesn't contend on a shared cache line (or lock the bus at all). The lanes are
+    // summed with relaxed loads only when the counters are read - at the end of a test case or
+    // when --abort-after is checked on a failure.
     //
-    // The disadvantage is that there is a small overhead due to the use of TLS, and load/store
-    // is slower because all atomics have to be accessed.
-    template <typename T>
-    class MultiLaneAtomic
+    // The lanes keep counting up - resetting the counters just moves the baseline. When a thread
+    // exits (or starts asserting for a different test run) the counts of its lane are folded into
+    // the totals of the test run it was registered with so nothing gets lost.
+    class AssertCounters
     {
-        struct CacheLineAlignedAtomic
+        struct Lane
         {
-            Atomic<T> atomic{};
-            char padding[DOCTEST_MULTI_LANE_ATOMICS_CACHE_LINE_SIZE - sizeof(Atomic<T>)];
+            Atomic<int>             asserts{0};
+            Atomic<int>             failed{0};
+            Atomic<AssertCounters*> owner{nullptr};
+
+            ~Lane() {
+                DOCTEST_LOCK_MUTEX(lanesMutex())
+                if(auto o = owner.load(std::memory_order_relaxed))
+                    o->retire(*this);
+            }
         };
-        CacheLineAlignedAtomic m_atomics[DOCTEST_MULTI_LANE_ATOMICS_THREAD_LANES];
 
-        static_assert(sizeof(CacheLineAlignedAtomic) == DOCTEST_MULTI_LANE_ATOMICS_CACHE_LINE_SIZE,
-                      "guarantee one atomic takes exactly one cache line");
+        std::vector<Lane*> m_lanes;
+        int                m_retiredAsserts = 0;
+        int                m_retiredFailed  = 0;
+        int                m_baseAsserts    = 0;
+        int                m_baseFailed     = 0;
 
-    public:
-        T operator++() DOCTEST_NOEXCEPT { return fetch_add(1) + 1; }
+        // registration is rare (once per thread and test run) so a single global mutex is enough
+        static std::mutex& lanesMutex() {
+            static std::mutex m;
+            return m;
+        }
+
+        static void bump(Atomic<int>& counter) {
+            counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
 
-        T operator++(int) DOCTEST_NOEXCEPT { return fetch_add(1); }
+        Lane& myLane() {
+            DOCTEST_THREAD_LOCAL Lane lane;
+            if(lane.owner.load(std::memory_order_relaxed) != this)
+                attach(lane);
+            return lane;
+        }
 
-        T fetch_add(T arg, std::memory_order order = std::memory_order_seq_cst) DOCTEST_NOEXCEPT {
-            return myAtomic().fetch_add(arg, order);
+        void attach(Lane& lane) {
+            DOCTEST_LOCK_MUTEX(lanesMutex())
+            if(auto o = lane.owner.load(std::memory_order_relaxed))
+                o->retire(lane);
+            // a lane without an owner may still hold the counts of an earlier test run
+            lane.asserts.store(0, std::memory_order_relaxed);
+            lane.failed.store(0, std::memory_order_relaxed);
+            lane.owner.store(this, std::memory_order_relaxed);
+            m_lanes.push_back(&lane);
         }
 
-        T fetch_sub(T arg, std::memory_order order = std::memory_order_seq_cst) DOCTEST_NOEXCEPT {
-            return myAtomic().fetch_sub(arg, order);
+        // with the mutex locked
+        void retire(Lane& lane) {
+            m_retiredAsserts += lane.asserts.load(std::memory_order_relaxed);
+            m_retiredFailed += lane.failed.load(std::memory_order_relaxed);
+            lane.asserts.store(0, std::memory_order_relaxed);
+            lane.failed.store(0, std::memory_order_relaxed);
+            lane.owner.store(nullptr, std::memory_order_relaxed);
+            m_lanes.erase(std::find(m_lanes.begin(), m_lanes.end(), &lane));
         }
 
-        operator T() const DOCTEST_NOEXCEPT { return load(); }
+        // with the mutex locked
+        int sum(Atomic<int> Lane::*counter, int retired) const {
+            for(auto lane : m_lanes)
+                retired += (lane->*counter).load(std::memory_order_relaxed);
+            return retired;
+        }
 
-        T load(std::memory_order order = std::memory_order_seq_cst) const DOCTEST_NOEXCEPT {
-            auto result = T();
-            for(auto const& c : m_atomics) {
-                result += c.atomic.load(order);
+    public:
+        AssertCounters() = default;
+        AssertCounters(const AssertCounters&) = delete;
+        AssertCounters& operator=(const AssertCounters&) = delete;
+
+        ~AssertCounters() {
+            DOCTEST_LOCK_MUTEX(lanesMutex())
+            for(auto lane : m_lanes) {
+                lane->asserts.store(0, std::memory_order_relaxed);
+                lane->failed.store(0, std::memory_order_relaxed);
+                lane->owner.store(nullptr, std::memory_order_relaxed);
             }
-            return result;
         }
 
-        T operator=(T desired) DOCTEST_NOEXCEPT { // lgtm [cpp/assignment-does-not-return-this]
-            store(desired);
-            return desired;
+        void addAssert() { bump(myLane().asserts); }
+        void addFailedAssert() { bump(myLane().failed); }
+
+        int numAsserts() const {
+            DOCTEST_LOCK_MUTEX(lanesMutex())
+            return sum(&Lane::asserts, m_retiredAsserts) - m_baseAsserts;
+        }
+        int numAssertsFailed() const {
+            DOCTEST_LOCK_MUTEX(lanesMutex())
+            return sum(&Lane::failed, m_retiredFailed) - m_baseFailed;
+        }
+
+        void reset(int asserts = 0, int failed = 0) {
+            DOCTEST_LOCK_MUTEX(lanesMutex())
+            m_baseAsserts = sum(&Lane::asserts, m_retiredAsserts) - asserts;
+            m_baseFailed  = sum(&Lane::failed, m_retiredFailed) - failed;
+        }
+    };
+#endif // DOCTEST_CONFIG_NO_MULTI_LANE_ATOMICS
+
+    // The filters of one kind (-tc, -sfe, ...) compiled once when the test run starts so checking
+    // a name doesn't go through wildcmp() for every mask. Masks without wildcards are looked up in
+    // a sorted array, masks with a single '*' at the end (or the start) walk a trie of prefixes (or
+    // reversed suffixes) and only the rest are matched with wildcmp(). All of them are folded to
+    // lower case upfront when matching is case insensitive. With DOCTEST_CONFIG_FILTER_REGEX masks
+    // starting with "re:" are regular expressions (ECMAScript) searched for anywhere in the name.
+    class FilterMatcher
+    {
+        struct Trie
+        {
+            struct Node
+            {
+                std::vector<std::pair<char, unsigned>> next;
+                bool                                   terminal = false;
+            };
+
+            std::vector<Node> nodes = decltype(nodes)(1);
+
+            void insert(const std::string& str, bool reversed);
+            bool matches(const char* str, size_t len, bool reversed, bool caseSensitive) const;
+        };
+
+        bool                     m_caseSensitive = false;
+        bool                     m_matchAll      = false;
+        size_t                   m_count         = 0;
+        std::vector<std::string> m_literals; // sorted
+        Trie                     m_prefixes;
+        Trie                     m_suffixes;
+        std::vector<std::string> m_masks;
+#ifdef DOCTEST_CONFIG_FILTER_REGEX
+        std::vector<std::regex> m_regexes;
+#endif // DOCTEST_CONFIG_FILTER_REGEX
+
+    public:
+        void compile(const std::vector<String>& filters, bool caseSensitive);
+
+        bool empty() const { return m_count == 0; }
+
+        // same as matchesAny() with the filters this was compiled from
+        bool matches(const char* name, bool matchEmpty) const;
+    };
+
+    // the durations of test cases measured by previous runs (see --durations-file) - a test case is
+    // identified by a hash of its file name (without the path), test suite and name so the entries
+    // survive rebuilds, moving the build directory and editing unrelated code around it
+    class DurationHistory
+    {
+        struct Entry
+        {
+            double seconds;
+            String name; // only for humans looking at the file
+        };
+
+        std::map<unsigned long long, Entry> m_entries;
+
+    public:
+        static unsigned long long id(const TestCase& tc);
+
+        bool load(const String& path);
+        bool save(const String& path) const;
+
+        bool empty() const { return m_entries.empty(); }
+
+        // negative for test cases which haven't been run before
+        double get(const TestCase& tc) const;
+
+        void record(const TestCase& tc, double seconds);
+    };
+
+    // The subcases seen by the test case which is running. Every subcase (file, line and name) and
+    // every path of subcases from the top of the test case (a node) are interned in flat open
+    // addressing tables the first time they are seen. A node is keyed by the node of its parent and
+    // the id of its subcase so two paths are the same node only if they really are the same - the
+    // stacks of subcases are just node ids and which paths were traversed can't get mixed up.
+    class SubcaseTree
+    {
+        struct Site
+        {
+            unsigned long long hash;
+            const char*        file;
+            int                line;
+            String             name;
+        };
+
+        struct Node
+        {
+            unsigned long long key; // the parent node in the upper half and the site in the lower
+            bool               traversed;
+        };
+
+        // indices + 1 of the sites/nodes - 0 for an empty slot
+        std::vector<Site>     m_sites;
+        std::vector<unsigned> m_siteTable;
+        std::vector<Node>     m_nodes;
+        std::vector<unsigned> m_nodeTable;
+
+        static bool same(const Site& site, const SubcaseSignature& sig) {
+            return site.line == sig.m_line &&
+                   (site.file == sig.m_file || std::strcmp(site.file, sig.m_file) == 0) &&
+                   site.name == sig.m_name;
+        }
+
+    public:
+        // forgets all subcases but keeps the memory for the next test case
+        void clear();
+
+        // the node of a subcase under the given parent node (0 is the top of the test case)
+        unsigned node(unsigned parent, const SubcaseSignature& sig);
+
+        // if the node is of the given subcase - without looking it up (the parent isn't checked)
+        bool is(unsigned node, const SubcaseSignature& sig) const {
+            return same(m_sites[(m_nodes[node - 1].key & 0xffffffffULL) - 1], sig);
+        }
+
+        SubcaseSignature signature(unsigned node) const {
+            const Site& site = m_sites[(m_nodes[node - 1].key & 0xffffffffULL) - 1];
+            return {site.name, site.file, site.line};
+        }
+
+        bool traversed(unsigned node) const { return m_nodes[node - 1].traversed; }
+        void setTraversed(unsigned node) { m_nodes[node - 1].traversed = true; }
+    };
+
+    // the heap usage of a thread - updated by the allocation functions which replace the default
+    // ones when DOCTEST_CONFIG_TRACK_ALLOCATIONS is defined
+    struct AllocationCounters
+    {
+        unsigned long long count;
+        unsigned long long bytes;
+        long long          live; // goes below zero when freeing memory allocated by other threads
+        long long          peak;
+    };
+
+    DOCTEST_THREAD_LOCAL_INITIAL_EXEC AllocationCounters g_allocations;
+
+    // the resources used by the calling thread (or by the process where that isn't available) until
+    // now - returns false if they can't be measured
+    struct ResourceSample
+    {
+        double             userSeconds;
+        double             systemSeconds;
+        long long          residentBytes;
+        long long          peakResidentBytes;
+        unsigned long long majorFaults;
+        unsigned long long minorFaults;
+        unsigned long long voluntarySwitches;
+        unsigned long long involuntarySwitches;
+    };
+
+    bool sampleResources(ResourceSample& out) {
+#ifdef DOCTEST_RESOURCE_USAGE
+#ifdef RUSAGE_THREAD
+        const int who = RUSAGE_THREAD; // the test cases of a --parallel run are on different threads
+#else  // RUSAGE_THREAD
+        const int who = RUSAGE_SELF;
+#endif // RUSAGE_THREAD
+        rusage usage;
+        if(getrusage(who, &usage) != 0)
+            return false;
+
+        out.userSeconds   = double(usage.ru_utime.tv_sec) + double(usage.ru_utime.tv_usec) / 1e6;
+        out.systemSeconds = double(usage.ru_stime.tv_sec) + double(usage.ru_stime.tv_usec) / 1e6;
+#ifdef DOCTEST_PLATFORM_MAC
+        out.peakResidentBytes = static_cast<long long>(usage.ru_maxrss); // bytes
+#else  // DOCTEST_PLATFORM_MAC
+        out.peakResidentBytes = static_cast<long long>(usage.ru_maxrss) * 1024; // kilobytes
+#endif // DOCTEST_PLATFORM_MAC
+        out.majorFaults         = static_cast<unsigned long long>(usage.ru_majflt);
+        out.minorFaults         = static_cast<unsigned long long>(usage.ru_minflt);
+        out.voluntarySwitches   = static_cast<unsigned long long>(usage.ru_nvcsw);
+        out.involuntarySwitches = static_cast<unsigned long long>(usage.ru_nivcsw);
+
+        // the current resident set size is the second field of /proc/self/statm (in pages) - it
+        // stays 0 where there is no procfs
+        out.residentBytes = 0;
+        if(FILE* statm = std::fopen("/proc/self/statm", "r")) {
+            long long size     = 0;
+            long long resident = 0;
+            if(std::fscanf(statm, "%lld %lld", &size, &resident) == 2)
+                out.residentBytes = resident * static_cast<long long>(sysconf(_SC_PAGESIZE));
+            std::fclose(statm);
         }
+        return true;
+#else  // DOCTEST_RESOURCE_USAGE
+        (void)out;
+        return false;
+#endif // DOCTEST_RESOURCE_USAGE
+    }
+
+    // the performance counters of the calling thread at some point in time (or a sum of differences)
+    struct PerfSample
+    {
+        unsigned measured; // a bit for each counter which could be read
+        double   values[PerfCounter::Count];
+    };
 
-        void store(T desired, std::memory_order order = std::memory_order_seq_cst) DOCTEST_NOEXCEPT {
-            // first value becomes desired", all others become 0.
-            for(auto& c : m_atomics) {
-                c.atomic.store(desired, order);
-                desired = {};
+    // the performance counters of a thread (see --perf-counters) - they are opened one by one when
+    // first sampled so the software ones are there even without hardware PMUs (as in containers)
+    class PerfCounterGroup
+    {
+        int  m_fds[PerfCounter::Count];
+        bool m_opened = false;
+
+        void open() {
+            m_opened = true;
+#ifdef DOCTEST_PERF_EVENTS
+            static const std::pair<std::uint32_t, std::uint64_t> events[PerfCounter::Count] = {
+                    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+                    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+                    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+                    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+                    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+                    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS}};
+#ifdef PERF_FLAG_FD_CLOEXEC
+            const unsigned long flags = PERF_FLAG_FD_CLOEXEC;
+#else  // PERF_FLAG_FD_CLOEXEC
+            const unsigned long flags = 0;
+#endif // PERF_FLAG_FD_CLOEXEC
+            for(int i = 0; i < PerfCounter::Count; ++i) {
+                perf_event_attr attr;
+                std::memset(&attr, 0, sizeof(attr));
+                attr.size   = sizeof(attr);
+                attr.type   = events[i].first;
+                attr.config = events[i].second;
+                // only user space is counted - that is allowed with the default perf_event_paranoid
+                attr.exclude_kernel = 1;
+                attr.exclude_hv     = 1;
+                attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+                // the calling thread on any CPU
+                m_fds[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, flags));
             }
+#endif // DOCTEST_PERF_EVENTS
         }
 
-    private:
-        // Each thread has a different atomic that it operates on. If more than NumLanes threads
-        // use this, some will use the same atomic. So performance will degrade a bit, but still
-        // everything will work.
-        //
-        // The logic here is a bit tricky. The call should be as fast as possible, so that there
-        // is minimal to no overhead in determining the correct atomic for the current thread.
-        //
-        // 1. A global static counter laneCounter counts continuously up.
-        // 2. Each successive thread will use modulo operation of that counter so it gets an atomic
-        //    assigned in a round-robin fashion.
-        // 3. This tlsLaneIdx is stored in the thread local data, so it is directly available with
-        //    little overhead.
-        Atomic<T>& myAtomic() DOCTEST_NOEXCEPT {
-            static Atomic<size_t> laneCounter;
-            DOCTEST_THREAD_LOCAL size_t tlsLaneIdx =
-                    laneCounter++ % DOCTEST_MULTI_LANE_ATOMICS_THREAD_LANES;
-
-            return m_atomics[tlsLaneIdx].atomic;
+    public:
+        PerfCounterGroup() {
+            for(auto& fd : m_fds)
+                fd = -1;
+        }
+
+        PerfCounterGroup(const PerfCounterGroup&)            = delete;
+        PerfCounterGroup& operator=(const PerfCounterGroup&) = delete;
+
+        ~PerfCounterGroup() {
+#ifdef DOCTEST_PERF_EVENTS
+            for(auto fd : m_fds)
+                if(fd >= 0)
+                    close(fd);
+#endif // DOCTEST_PERF_EVENTS
+        }
+
+        void sample(PerfSample& out) {
+            if(!m_opened)
+                open();
+            out.measured = 0;
+            for(int i = 0; i < PerfCounter::Count; ++i) {
+                out.values[i] = 0;
+#ifdef DOCTEST_PERF_EVENTS
+                // the value and the times the counter was enabled and running - when there are
+                // more counters than the PMU has it is multiplexed so the value is scaled up
+                std::uint64_t data[3];
+                if(m_fds[i] < 0 || read(m_fds[i], data, sizeof(data)) != sizeof(data) || !data[2])
+                    continue;
+                out.values[i] = double(data[0]) * double(data[1]) / double(data[2]);
+                out.measured |= 1u << i;
+#endif // DOCTEST_PERF_EVENTS
+            }
         }
     };
-#endif // DOCTEST_CONFIG_NO_MULTI_LANE_ATOMICS
+
+    DOCTEST_THREAD_LOCAL PerfCounterGroup g_perfCounters;
+
+    // adds the change of the counters between 2 samples to a total
+    void addPerfCounters(PerfSample& total, const PerfSample& from, const PerfSample& to) {
+        total.measured &= from.measured & to.measured;
+        for(int i = 0; i < PerfCounter::Count; ++i)
+            total.values[i] += to.values[i] - from.values[i];
+    }
+
+    class Watchdog;
 
     // this holds both parameters from the command line and runtime data for tests
     struct ContextState : ContextOptions, TestRunStats, CurrentTestCaseStats
     {
-        MultiLaneAtomic<int> numAssertsCurrentTest_atomic;
-        MultiLaneAtomic<int> numAssertsFailedCurrentTest_atomic;
+        AssertCounters assertCounters;
 
         std::vector<std::vector<String>> filters = decltype(filters)(9); // 9 different filters
+        std::vector<FilterMatcher> filterMatchers = decltype(filterMatchers)(8); // all but reporters
+
+        DurationHistory durationHistory;
 
         std::vector<IReporter*> reporters_currently_used;
+        bool                    report_successful_asserts = true; // or just count them
 
         assert_handler ah = nullptr;
 
         Timer timer;
 
+        Watchdog* watchdog = nullptr; // set for the run if there is a --test-timeout
+
+        AllocationCounters* allocations = nullptr; // of the thread executing the current test case
+        AllocationCounters  allocationsAtStart = {};
+
+        bool           resourcesSampled   = false; // if resourcesAtStart holds a sample
+        ResourceSample resourcesAtStart   = {};
+
+        PerfSample              perfAtStart = {}; // of the current test case (see --perf-counters)
+        std::vector<PerfSample> subcasePerfStack; // of the entered subcases
+
         std::vector<String> stringifiedContexts; // logging from INFO() due to an exception
 
-        // stuff for subcases
+#ifndef DOCTEST_CONFIG_NO_MULTITHREADING
+        // for the states which execute test code on threads of their own (see spawnedThreadState())
+        ContextState*     parentState = nullptr; // of the test case a parallel_subcases() pass is of
+        std::atomic<bool> strayAsserts{false};   // a thread it might have started couldn't be told apart
+#endif // DOCTEST_CONFIG_NO_MULTITHREADING
+
+        // stuff for subcases - the stacks hold nodes of the subcase tree
         bool reachedLeaf;
-        std::vector<SubcaseSignature> subcaseStack;
-        std::vector<SubcaseSignature> nextSubcaseStack;
-        std::unordered_set<unsigned long long> fullyTraversedSubcases;
+        SubcaseTree subcaseTree;
+        std::vector<unsigned> subcaseStack;
+        std::vector<unsigned> nextSubcaseStack;
         size_t currentSubcaseDepth;
+        // set for the passes of a test case with parallel_subcases() - the untraversed subcases
+        // below the forced path are collected as the paths of new passes instead of being entered
+        std::vector<std::vector<SubcaseSignature>>* discoveredSubcases = nullptr;
+        size_t forcedSubcaseDepth = 0;
         Atomic<bool> shouldLogCurrentException;
 
+        // the values of test_cache() and the blocks of ONCE_PER_TEST for the current test case
+        struct TestCacheEntry
+        {
+            String type;
+            String name;
+            void*  value;
+            void (*destroy)(void*);
+        };
+        std::vector<TestCacheEntry> testCache;
+
+        void releaseTestCache() {
+            while(!testCache.empty()) {
+                const TestCacheEntry entry = testCache.back();
+                testCache.pop_back();
+                if(entry.destroy)
+                    entry.destroy(entry.value);
+            }
+        }
+
         void resetRunData() {
             numTestCases                = 0;
             numTestCasesPassingFilters  = 0;
@@ -456,20 +887,68 @@ using ticks_t = timer_large_integer::type;
             numAssertsFailedCurrentTest = 0;
         }
 
+        // the timeout decorator of a test case or --test-timeout if it doesn't have one
+        double timeLimit(const TestCaseData& tc) const {
+            return tc.m_timeout > 0 ? tc.m_timeout : double(test_timeout);
+        }
+
+        void measureResources() {
+            resourcesMeasured = false;
+            userSeconds = systemSeconds = 0;
+            residentBytes = peakResidentBytes = 0;
+            majorFaults = minorFaults = voluntarySwitches = involuntarySwitches = 0;
+
+            ResourceSample now;
+            if(!resourcesSampled || !sampleResources(now))
+                return;
+
+            // a counter may appear to go back if the sample isn't of the thread which ran the test
+            // case (when the watchdog stops it) - such differences are clamped to 0
+            const ResourceSample& start = resourcesAtStart;
+            auto counted = [](unsigned long long to, unsigned long long from) {
+                return to > from ? to - from : 0;
+            };
+            resourcesMeasured   = true;
+            userSeconds         = std::max(now.userSeconds - start.userSeconds, 0.0);
+            systemSeconds       = std::max(now.systemSeconds - start.systemSeconds, 0.0);
+            residentBytes       = now.residentBytes - start.residentBytes;
+            peakResidentBytes   = now.peakResidentBytes - start.peakResidentBytes;
+            majorFaults         = counted(now.majorFaults, start.majorFaults);
+            minorFaults         = counted(now.minorFaults, start.minorFaults);
+            voluntarySwitches   = counted(now.voluntarySwitches, start.voluntarySwitches);
+            involuntarySwitches = counted(now.involuntarySwitches, start.involuntarySwitches);
+        }
+
         void finalizeTestCaseData() {
             seconds = timer.getElapsedSeconds();
 
+            allocationsTracked = false;
+            numAllocations = allocatedBytes = peakAllocatedBytes = 0;
+#ifdef DOCTEST_CONFIG_TRACK_ALLOCATIONS
+            if(allocations) {
+                allocationsTracked = true;
+                numAllocations     = allocations->count - allocationsAtStart.count;
+                allocatedBytes     = allocations->bytes - allocationsAtStart.bytes;
+                if(allocations->peak > allocationsAtStart.live)
+                    peakAllocatedBytes =
+                            static_cast<unsigned long long>(allocations->peak - allocationsAtStart.live);
+            }
+#endif // DOCTEST_CONFIG_TRACK_ALLOCATIONS
+
+            measureResources();
+
             // update the non-atomic counters
-            numAsserts += numAssertsCurrentTest_atomic;
-            numAssertsFailed += numAssertsFailedCurrentTest_atomic;
-            numAssertsCurrentTest       = numAssertsCurrentTest_atomic;
-            numAssertsFailedCurrentTest = numAssertsFailedCurrentTest_atomic;
+            numAssertsCurrentTest       = assertCounters.numAsserts();
+            numAssertsFailedCurrentTest = assertCounters.numAssertsFailed();
+            numAsserts += numAssertsCurrentTest;
+            numAssertsFailed += numAssertsFailedCurrentTest;
 
             if(numAssertsFailedCurrentTest)
                 failure_flags |= TestCaseFailureReason::AssertFailure;
 
-            if(Approx(currentTest->m_timeout).epsilon(DBL_EPSILON) != 0 &&
-               Approx(seconds).epsilon(DBL_EPSILON) > currentTest->m_timeout)
+            const double limit = timeLimit(*currentTest);
+            if(Approx(limit).epsilon(DBL_EPSILON) != 0 &&
+               Approx(seconds).epsilon(DBL_EPSILON) > limit)
                 failure_flags |= TestCaseFailureReason::Timeout;
 
             if(currentTest->m_should_fail) {
@@ -501,6 +980,115 @@ using ticks_t = timer_large_integer::type;
 
     ContextState* g_cs = nullptr;
 
+    // the worker threads of a parallel run (see --parallel) execute test cases against their own
+    // copy of the run data - subcase stacks, counters, stringified contexts and reporters
+    DOCTEST_THREAD_LOCAL ContextState* g_worker_cs = nullptr;
+
+    // set for the threads of doctest itself which aren't workers - the one in Context::run() (which
+    // executes the test cases or hands them to the workers) and the watchdog
+    DOCTEST_THREAD_LOCAL bool g_doctest_thread = false;
+
+#ifndef DOCTEST_CONFIG_NO_MULTITHREADING
+    // the states which execute test code on threads of their own - the workers of --parallel and the
+    // passes of parallel_subcases(). A thread started by the test code isn't bound to any state so
+    // its asserts go to the state executing at that time - when it can't be told which one of many
+    // has started the thread they all get marked and execute their test code again on their own.
+    struct ExecutingStates
+    {
+        DOCTEST_DECLARE_MUTEX(mutex)
+        std::vector<ContextState*> states;
+        ContextState               stray; // gets the asserts which can't be attributed - unreported
+    };
+
+    std::atomic<size_t> g_numExecutingStates{0};
+
+    ExecutingStates& getExecutingStates() {
+        static ExecutingStates data;
+        return data;
+    }
+
+    // registers a state while it executes test code
+    class ExecutingScope
+    {
+        ContextState* m_state;
+
+    public:
+        ExecutingScope(ContextState* s, ContextState* parent)
+                : m_state(s) {
+            ExecutingStates& data = getExecutingStates();
+            DOCTEST_LOCK_MUTEX(data.mutex)
+            s->parentState = parent;
+            s->strayAsserts = false;
+            data.states.push_back(s);
+            ++g_numExecutingStates;
+        }
+
+        ExecutingScope(const ExecutingScope&) = delete;
+        ExecutingScope& operator=(const ExecutingScope&) = delete;
+
+        ~ExecutingScope() {
+            ExecutingStates& data = getExecutingStates();
+            DOCTEST_LOCK_MUTEX(data.mutex)
+            data.states.erase(std::find(data.states.begin(), data.states.end(), m_state));
+            --g_numExecutingStates;
+        }
+    };
+
+    // the state for a thread started by test code - a worker executing a test case whose passes of
+    // parallel_subcases() are executing isn't a candidate since it is waiting for them
+    ContextState* spawnedThreadState() {
+        ExecutingStates& data = getExecutingStates();
+        DOCTEST_LOCK_MUTEX(data.mutex)
+        auto isParent = [&](const ContextState* s) {
+            for(auto other : data.states)
+                if(other->parentState == s)
+                    return true;
+            return false;
+        };
+        ContextState* found = nullptr;
+        int           num   = 0;
+        for(auto s : data.states) {
+            if(!isParent(s)) {
+                found = s;
+                ++num;
+            }
+        }
+        if(num == 0)
+            return g_cs;
+        if(num == 1)
+            return found;
+        for(auto s : data.states)
+            if(!isParent(s))
+                for(auto curr = s; curr; curr = curr->parentState)
+                    curr->strayAsserts = true;
+        return &data.stray;
+    }
+#endif // DOCTEST_CONFIG_NO_MULTITHREADING
+
+    // the run data of the test case executing on the calling thread - the workers have their own
+    // copy, threads started by the tests get the one of the test code executing meanwhile
+    ContextState* currentState() {
+        if(g_worker_cs)
+            return g_worker_cs;
+#ifndef DOCTEST_CONFIG_NO_MULTITHREADING
+        if(!g_doctest_thread && g_numExecutingStates.load(std::memory_order_acquire) != 0)
+            return spawnedThreadState();
+#endif // DOCTEST_CONFIG_NO_MULTITHREADING
+        return g_cs;
+    }
+
+#ifndef DOCTEST_CONFIG_NO_MULTITHREADING
+    // with --thread-logs the asserts and messages of the threads started by the test cases on
+    // their own are logged by each such thread and delivered together when the subcase ends
+    bool logOnOwnThread(const AssertData& ad);
+    bool logOnOwnThread(const MessageData& mb);
+    void deliverThreadLogs(ContextState* p);
+#else  // DOCTEST_CONFIG_NO_MULTITHREADING
+    bool logOnOwnThread(const AssertData&) { return false; }
+    bool logOnOwnThread(const MessageData&) { return false; }
+    void deliverThreadLogs(ContextState*) {}
+#endif // DOCTEST_CONFIG_NO_MULTITHREADING
+
     // used to avoid locks for the debug output
     // TODO: figure out if this is indeed necessary/correct - seems like either there still
     // could be a race or that there wouldn't be a race even if using the context directly
@@ -741,8 +1329,10 @@ namespace Color {
     }
 } // namespace Color
 
+namespace {
 // clang-format off
-const char* assertString(assertType::Enum at) {
+// the name of an assert type - null for a value which isn't one (as in a corrupted recording)
+const char* assertTypeName(int at) {
     DOCTEST_MSVC_SUPPRESS_WARNING_WITH_PUSH(4061) // enum 'x' in switch of enum 'y' is not explicitly handled
     #define DOCTEST_GENERATE_ASSERT_TYPE_CASE(assert_type) case assertType::DT_ ## assert_type: return #assert_type
     #define DOCTEST_GENERATE_ASSERT_TYPE_CASES(assert_type) \
@@ -776,11 +1366,18 @@ const char* assertString(assertType::Enum at) {
         DOCTEST_GENERATE_ASSERT_TYPE_CASES(UNARY);
         DOCTEST_GENERATE_ASSERT_TYPE_CASES(UNARY_FALSE);
 
-        default: DOCTEST_INTERNAL_ERROR("Tried stringifying invalid assert type!");
+        default: return nullptr;
     }
     DOCTEST_MSVC_SUPPRESS_WARNING_POP
 }
 // clang-format on
+} // namespace
+
+const char* assertString(assertType::Enum at) {
+    if(const char* name = assertTypeName(at))
+        return name;
+    DOCTEST_INTERNAL_ERROR("Tried stringifying invalid assert type!");
+}
 
 const char* failureString(assertType::Enum at) {
     if(at & assertType::is_warn) //!OCLINT bitwise operator in conditional
@@ -934,7 +1531,11 @@ bool operator>(const Approx& lhs, double rhs) { return lhs.m_value > rhs && lhs
 String toString(const Approx& in) {
     return "Approx( " + doctest::toString(in.m_value) + " )";
 }
-const ContextOptions* getContextOptions() { return DOCTEST_BRANCH_ON_DISABLED(nullptr, g_cs); }
+const ContextOptions* getContextOptions() { return DOCTEST_BRANCH_ON_DISABLED(nullptr, currentState()); }
+
+namespace detail {
+    void useBenchmarkValue(const volatile void*) {}
+} // namespace detail
 
 DOCTEST_MSVC_SUPPRESS_WARNING_WITH_PUSH(4738)
 template <typename F>
@@ -997,6 +1598,21 @@ doctest::detail::TestSuite& getCurrentTestSuite() {
 }
 } // namespace doctest_detail_test_suite_ns
 
+#ifdef __ELF__
+// the bounds of the section with the entries of DOCTEST_CONFIG_TEST_SECTION are defined by the
+// linker - they are null if there are no entries and every shared object has its own section
+DOCTEST_CLANG_SUPPRESS_WARNING_PUSH
+DOCTEST_CLANG_SUPPRESS_WARNING("-Wunknown-warning-option")
+DOCTEST_CLANG_SUPPRESS_WARNING("-Wreserved-identifier")
+extern "C" {
+extern const doctest::detail::TestSectionEntry* const __start_doctest_tests[]
+        __attribute__((weak, visibility("hidden")));
+extern const doctest::detail::TestSectionEntry* const __stop_doctest_tests[]
+        __attribute__((weak, visibility("hidden")));
+}
+DOCTEST_CLANG_SUPPRESS_WARNING_POP
+#endif // __ELF__
+
 namespace doctest {
 namespace {
     // the int (priority) is part of the key for automatic sorting - sadly one can register a
@@ -1014,16 +1630,17 @@ namespace {
 } // namespace
 namespace detail {
 #define DOCTEST_ITERATE_THROUGH_REPORTERS(function, ...)                                           \
-    for(auto& curr_rep : g_cs->reporters_currently_used)                                           \
+    for(auto& curr_rep : currentState()->reporters_currently_used)                                 \
     curr_rep->function(__VA_ARGS__)
 
     bool checkIfShouldThrow(assertType::Enum at) {
         if(at & assertType::is_require) //!OCLINT bitwise operator in conditional
             return true;
 
+        ContextState* const cs = currentState();
         if((at & assertType::is_check) //!OCLINT bitwise operator in conditional
            && getContextOptions()->abort_after > 0 &&
-           (g_cs->numAssertsFailed + g_cs->numAssertsFailedCurrentTest_atomic) >=
+           (cs->numAssertsFailed + cs->assertCounters.numAssertsFailed()) >=
                    getContextOptions()->abort_after)
             return true;
 
@@ -1032,7 +1649,7 @@ namespace detail {
 
 #ifndef DOCTEST_CONFIG_NO_EXCEPTIONS
     DOCTEST_NORETURN void throwException() {
-        g_cs->shouldLogCurrentException = false;
+        currentState()->shouldLogCurrentException = false;
         throw TestFailureException(); // NOLINT(hicpp-exception-baseclass)
     }
 #else // DOCTEST_CONFIG_NO_EXCEPTIONS
@@ -1091,126 +1708,573 @@ namespace {
         return false;
     }
 
-    DOCTEST_NO_SANITIZE_INTEGER
-    unsigned long long hash(unsigned long long a, unsigned long long b) {
-        return (a << 5) + b;
+    char foldCase(char c) { return static_cast<char>(tolower(static_cast<unsigned char>(c))); }
+
+    // compares an already folded mask with a name just like strcmp()
+    int compareFolded(const char* mask, const char* name, bool caseSensitive) {
+        for(;; ++mask, ++name) {
+            const char c = caseSensitive ? *name : foldCase(*name);
+            if(*mask != c || c == '\0')
+                return static_cast<unsigned char>(*mask) - static_cast<unsigned char>(c);
+        }
     }
 
-    // C string hash function (djb2) - taken from http://www.cse.yorku.ca/~oz/hash.html
+    // FNV-1a over the bytes
     DOCTEST_NO_SANITIZE_INTEGER
-    unsigned long long hash(const char* str) {
-        unsigned long long hash = 5381;
-        char c;
-        while ((c = *str++))
-            hash = ((hash << 5) + hash) + c; // hash * 33 + c
-        return hash;
+    unsigned long long hash(const char* str, size_t len) {
+        unsigned long long res = 14695981039346656037ULL;
+        for(size_t i = 0; i < len; ++i) {
+            res ^= static_cast<unsigned char>(str[i]);
+            res *= 1099511628211ULL;
+        }
+        return res;
     }
 
-    unsigned long long hash(const SubcaseSignature& sig) {
-        return hash(hash(hash(sig.m_file), hash(sig.m_name.c_str())), sig.m_line);
+    // the finalizer of splitmix64 - spreads keys which differ only in a few bits over the table
+    DOCTEST_NO_SANITIZE_INTEGER
+    unsigned long long mix(unsigned long long x) {
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
     }
 
-    unsigned long long hash(const std::vector<SubcaseSignature>& sigs, size_t count) {
-        unsigned long long running = 0;
-        auto end = sigs.begin() + count;
-        for (auto it = sigs.begin(); it != end; it++) {
-            running = hash(running, hash(*it));
-        }
-        return running;
+    // the slot in an open addressing table of indices + 1 which holds the item for which same() is
+    // true - or the empty slot where it should go
+    template <typename F>
+    unsigned& findSlot(std::vector<unsigned>& table, unsigned long long hash, F same) {
+        const size_t mask = table.size() - 1;
+        size_t       slot = static_cast<size_t>(hash) & mask;
+        while(table[slot] != 0 && !same(table[slot] - 1))
+            slot = (slot + 1) & mask;
+        return table[slot];
     }
 
-    unsigned long long hash(const std::vector<SubcaseSignature>& sigs) {
-        unsigned long long running = 0;
-        for (const SubcaseSignature& sig : sigs) {
-            running = hash(running, hash(sig));
-        }
-        return running;
+    // makes room for one more item - the table is kept at most half full
+    template <typename F>
+    void reserveSlot(std::vector<unsigned>& table, size_t count, F hashOf) {
+        if((count + 1) * 2 <= table.size())
+            return;
+        table.assign(table.empty() ? 16 : table.size() * 2, 0);
+        for(size_t i = 0; i < count; ++i)
+            findSlot(table, hashOf(i), [](unsigned) { return false; }) = unsigned(i + 1);
     }
 } // namespace
 namespace detail {
-    bool Subcase::checkFilters() {
-        if (g_cs->subcaseStack.size() < size_t(g_cs->subcase_filter_levels)) {
-            if (!matchesAny(m_signature.m_name.c_str(), g_cs->filters[6], true, g_cs->case_sensitive))
-                return true;
-            if (matchesAny(m_signature.m_name.c_str(), g_cs->filters[7], false, g_cs->case_sensitive))
-                return true;
+    void FilterMatcher::Trie::insert(const std::string& str, bool reversed) {
+        unsigned curr = 0;
+        for(size_t i = 0; i < str.size(); ++i) {
+            const char c    = str[reversed ? str.size() - 1 - i : i];
+            auto&      next = nodes[curr].next;
+            auto       it   = std::find_if(next.begin(), next.end(),
+                                           [c](const std::pair<char, unsigned>& n) { return n.first == c; });
+            if(it != next.end()) {
+                curr = it->second;
+            } else {
+                next.emplace_back(c, unsigned(nodes.size()));
+                curr = unsigned(nodes.size());
+                nodes.emplace_back();
+            }
         }
-        return false;
+        nodes[curr].terminal = true;
     }
 
-    Subcase::Subcase(const String& name, const char* file, int line)
-            : m_signature({name, file, line}) {
-        if (!g_cs->reachedLeaf) {
-            if (g_cs->nextSubcaseStack.size() <= g_cs->subcaseStack.size()
-                || g_cs->nextSubcaseStack[g_cs->subcaseStack.size()] == m_signature) {
-                // Going down.
-                if (checkFilters()) { return; }
+    bool FilterMatcher::Trie::matches(const char* str, size_t len, bool reversed,
+                                      bool caseSensitive) const {
+        unsigned curr = 0;
+        for(size_t i = 0; i < len && !nodes[curr].terminal; ++i) {
+            char c = str[reversed ? len - 1 - i : i];
+            if(!caseSensitive)
+                c = foldCase(c);
+            const auto& next = nodes[curr].next;
+            auto        it   = std::find_if(next.begin(), next.end(),
+                                            [c](const std::pair<char, unsigned>& n) { return n.first == c; });
+            if(it == next.end())
+                return false;
+            curr = it->second;
+        }
+        return nodes[curr].terminal;
+    }
 
-                g_cs->subcaseStack.push_back(m_signature);
-                g_cs->currentSubcaseDepth++;
-                m_entered = true;
-                DOCTEST_ITERATE_THROUGH_REPORTERS(subcase_start, m_signature);
+    void FilterMatcher::compile(const std::vector<String>& filters, bool caseSensitive) {
+        *this           = FilterMatcher();
+        m_caseSensitive = caseSensitive;
+        m_count         = filters.size();
+
+        for(auto& curr : filters) {
+            std::string mask = curr.c_str();
+
+#ifdef DOCTEST_CONFIG_FILTER_REGEX
+            if(mask.compare(0, 3, "re:") == 0) {
+                auto flags = std::regex::ECMAScript | std::regex::optimize;
+                if(!caseSensitive)
+                    flags |= std::regex::icase;
+#ifndef DOCTEST_CONFIG_NO_EXCEPTIONS
+                try {
+                    m_regexes.emplace_back(mask.substr(3), flags);
+                } catch(const std::regex_error&) {} // an invalid regex matches nothing
+#else // DOCTEST_CONFIG_NO_EXCEPTIONS
+                m_regexes.emplace_back(mask.substr(3), flags);
+#endif // DOCTEST_CONFIG_NO_EXCEPTIONS
+                continue;
             }
-        } else {
-            if (g_cs->subcaseStack[g_cs->currentSubcaseDepth] == m_signature) {
-                // This subcase is reentered via control flow.
-                g_cs->currentSubcaseDepth++;
-                m_entered = true;
-                DOCTEST_ITERATE_THROUGH_REPORTERS(subcase_start, m_signature);
-            } else if (g_cs->nextSubcaseStack.size() <= g_cs->currentSubcaseDepth
-                    && g_cs->fullyTraversedSubcases.find(hash(hash(g_cs->subcaseStack, g_cs->currentSubcaseDepth), hash(m_signature)))
-                    == g_cs->fullyTraversedSubcases.end()) {
-                if (checkFilters()) { return; }
-                // This subcase is part of the one to be executed next.
-                g_cs->nextSubcaseStack.clear();
-                g_cs->nextSubcaseStack.insert(g_cs->nextSubcaseStack.end(),
-                    g_cs->subcaseStack.begin(), g_cs->subcaseStack.begin() + g_cs->currentSubcaseDepth);
-                g_cs->nextSubcaseStack.push_back(m_signature);
+#endif // DOCTEST_CONFIG_FILTER_REGEX
+
+            if(!caseSensitive)
+                std::transform(mask.begin(), mask.end(), mask.begin(), foldCase);
+
+            const auto stars = std::count(mask.begin(), mask.end(), '*');
+            if(mask.find('?') != std::string::npos) {
+                m_masks.push_back(mask);
+            } else if(size_t(stars) == mask.size()) {
+                m_matchAll = true;
+            } else if(stars == 0) {
+                m_literals.push_back(mask);
+            } else if(stars == 1 && mask.back() == '*') {
+                m_prefixes.insert(mask.substr(0, mask.size() - 1), false);
+            } else if(stars == 1 && mask.front() == '*') {
+                m_suffixes.insert(mask.substr(1), true);
+            } else {
+                m_masks.push_back(mask);
             }
         }
+
+        std::sort(m_literals.begin(), m_literals.end());
     }
 
-    DOCTEST_MSVC_SUPPRESS_WARNING_WITH_PUSH(4996) // std::uncaught_exception is deprecated in C++17
-    DOCTEST_GCC_SUPPRESS_WARNING_WITH_PUSH("-Wdeprecated-declarations")
-    DOCTEST_CLANG_SUPPRESS_WARNING_WITH_PUSH("-Wdeprecated-declarations")
+    bool FilterMatcher::matches(const char* name, bool matchEmpty) const {
+        if(m_count == 0)
+            return matchEmpty;
+        if(m_matchAll)
+            return true;
 
-    Subcase::~Subcase() {
-        if (m_entered) {
-            g_cs->currentSubcaseDepth--;
+        if(!m_literals.empty()) {
+            auto it = std::lower_bound(m_literals.begin(), m_literals.end(), name,
+                                       [this](const std::string& lit, const char* n) {
+                                           return compareFolded(lit.c_str(), n, m_caseSensitive) < 0;
+                                       });
+            if(it != m_literals.end() && compareFolded(it->c_str(), name, m_caseSensitive) == 0)
+                return true;
+        }
 
-            if (!g_cs->reachedLeaf) {
-                // Leaf.
-                g_cs->fullyTraversedSubcases.insert(hash(g_cs->subcaseStack));
-                g_cs->nextSubcaseStack.clear();
-                g_cs->reachedLeaf = true;
-            } else if (g_cs->nextSubcaseStack.empty()) {
-                // All children are finished.
-                g_cs->fullyTraversedSubcases.insert(hash(g_cs->subcaseStack));
-            }
+        const size_t len = strlen(name);
+        if(m_prefixes.nodes.size() > 1 && m_prefixes.matches(name, len, false, m_caseSensitive))
+            return true;
+        if(m_suffixes.nodes.size() > 1 && m_suffixes.matches(name, len, true, m_caseSensitive))
+            return true;
 
-#if defined(__cpp_lib_uncaught_exceptions) && __cpp_lib_uncaught_exceptions >= 201411L && (!defined(__MAC_OS_X_VERSION_MIN_REQUIRED) || __MAC_OS_X_VERSION_MIN_REQUIRED >= 101200)
-            if(std::uncaught_exceptions() > 0
-#else
-            if(std::uncaught_exception()
-#endif
-                && g_cs->shouldLogCurrentException) {
-                DOCTEST_ITERATE_THROUGH_REPORTERS(
-                        test_case_exception, {"exception thrown in subcase - will translate later "
-                                                "when the whole test case has been exited (cannot "
-                                                "translate while there is an active exception)",
-                                                false});
-                g_cs->shouldLogCurrentException = false;
-            }
+        for(auto& curr : m_masks)
+            if(wildcmp(name, curr.c_str(), m_caseSensitive))
+                return true;
+#ifdef DOCTEST_CONFIG_FILTER_REGEX
+        for(auto& curr : m_regexes)
+            if(std::regex_search(name, name + len, curr))
+                return true;
+#endif // DOCTEST_CONFIG_FILTER_REGEX
+        return false;
+    }
 
-            DOCTEST_ITERATE_THROUGH_REPORTERS(subcase_end, DOCTEST_EMPTY);
+    // FNV-1a over the bytes (as unsigned chars) so the ids in the file are the same on every
+    // platform
+    DOCTEST_NO_SANITIZE_INTEGER
+    unsigned long long DurationHistory::id(const TestCase& tc) {
+        const char* file = tc.m_file.c_str();
+        for(const char* c = file; *c; ++c)
+            if(*c == '/' || *c == '\\')
+                file = c + 1;
+
+        unsigned long long res = 14695981039346656037ULL;
+        for(const char* str : {file, tc.m_test_suite, tc.m_name}) {
+            // the terminating null separates the strings
+            do {
+                res ^= static_cast<unsigned char>(*str);
+                res *= 1099511628211ULL;
+            } while(*str++);
         }
+        return res;
     }
 
-    DOCTEST_CLANG_SUPPRESS_WARNING_POP
-    DOCTEST_GCC_SUPPRESS_WARNING_POP
-    DOCTEST_MSVC_SUPPRESS_WARNING_POP
+    bool DurationHistory::load(const String& path) {
+        std::ifstream in(path.c_str());
+        if(!in)
+            return false;
 
-    Subcase::operator bool() const { return m_entered; }
+        std::string line;
+        while(std::getline(in, line)) {
+            if(line.empty() || line[0] == '#')
+                continue;
+
+            std::istringstream ss(line);
+            unsigned long long key;
+            Entry              entry;
+            if(!(ss >> std::hex >> key >> std::dec >> entry.seconds) || entry.seconds < 0)
+                continue;
+            std::string name;
+            std::getline(ss >> std::ws, name);
+            entry.name = name.c_str();
+
+            m_entries[key] = entry;
+        }
+        return true;
+    }
+
+    bool DurationHistory::save(const String& path) const {
+        // written to a temporary file first so a run which gets killed doesn't lose the history
+        const String tmp = path + ".tmp";
+        {
+            std::ofstream out(tmp.c_str());
+            if(!out)
+                return false;
+
+            out << "# doctest test case durations: <id> <seconds> <test case>\n";
+            out << std::setprecision(9) << std::fixed;
+            for(auto& curr : m_entries)
+                out << std::hex << std::setw(16) << std::setfill('0') << curr.first << std::dec
+                    << std::setfill(' ') << " " << curr.second.seconds << " "
+                    << curr.second.name << "\n";
+
+            if(!out.flush())
+                return false;
+        }
+
+        if(std::rename(tmp.c_str(), path.c_str()) != 0) {
+            // rename() doesn't replace existing files on Windows
+            std::remove(path.c_str());
+            if(std::rename(tmp.c_str(), path.c_str()) != 0) {
+                std::remove(tmp.c_str());
+                return false;
+            }
+        }
+        return true;
+    }
+
+    double DurationHistory::get(const TestCase& tc) const {
+        auto it = m_entries.find(id(tc));
+        return it == m_entries.end() ? -1 : it->second.seconds;
+    }
+
+    void DurationHistory::record(const TestCase& tc, double seconds) {
+        auto res = m_entries.insert({id(tc), Entry{seconds, ""}});
+        // averaged with the history so a single slow run doesn't reshuffle the whole order
+        if(!res.second)
+            res.first->second.seconds = (res.first->second.seconds + seconds) / 2;
+        res.first->second.name = tc.m_test_suite[0] != '\0' ?
+                                         String(tc.m_test_suite) + "/" + tc.m_name :
+                                         String(tc.m_name);
+    }
+
+    void SubcaseTree::clear() {
+        m_sites.clear();
+        m_siteTable.clear();
+        m_nodes.clear();
+        m_nodeTable.clear();
+    }
+
+    unsigned SubcaseTree::node(unsigned parent, const SubcaseSignature& sig) {
+        // the file isn't hashed - different translation units might have different copies of it
+        const unsigned long long siteHash =
+                mix(hash(sig.m_name.c_str(), sig.m_name.size()) ^ static_cast<unsigned>(sig.m_line));
+        reserveSlot(m_siteTable, m_sites.size(), [this](size_t i) { return m_sites[i].hash; });
+        unsigned& site = findSlot(m_siteTable, siteHash, [&](unsigned i) {
+            return m_sites[i].hash == siteHash && same(m_sites[i], sig);
+        });
+        if(site == 0) {
+            m_sites.push_back({siteHash, sig.m_file, sig.m_line, sig.m_name});
+            site = unsigned(m_sites.size());
+        }
+
+        const unsigned long long key = (static_cast<unsigned long long>(parent) << 32) | site;
+        reserveSlot(m_nodeTable, m_nodes.size(), [this](size_t i) { return mix(m_nodes[i].key); });
+        unsigned& node = findSlot(m_nodeTable, mix(key),
+                                  [&](unsigned i) { return m_nodes[i].key == key; });
+        if(node == 0) {
+            m_nodes.push_back({key, false});
+            node = unsigned(m_nodes.size());
+        }
+        return node;
+    }
+
+    // the change of the performance counters of the calling thread since a sample
+    PerfSample perfCountersSince(const PerfSample& start) {
+        PerfSample now;
+        g_perfCounters.sample(now);
+        PerfSample total = {~0u, {}};
+        addPerfCounters(total, start, now);
+        return total;
+    }
+
+    void reportPerfCounters(PerfCounterScope::Enum scope, const String& name, const char* file,
+                            int line, const PerfSample& total, double iterations = 1) {
+        if(!total.measured)
+            return;
+        PerfCounterStats st;
+        st.m_scope    = scope;
+        st.m_name     = name;
+        st.m_file     = file;
+        st.m_line     = line;
+        st.m_measured = total.measured;
+        for(int i = 0; i < PerfCounter::Count; ++i)
+            st.m_values[i] = st.measured(PerfCounter::Enum(i)) ? total.values[i] / iterations : 0;
+        DOCTEST_ITERATE_THROUGH_REPORTERS(perf_counters, st);
+    }
+
+    void startSubcasePerfCounters(ContextState* cs) {
+        if(!cs->perf_counters)
+            return;
+        cs->subcasePerfStack.emplace_back();
+        g_perfCounters.sample(cs->subcasePerfStack.back());
+    }
+
+    bool Subcase::checkFilters() {
+        ContextState* const cs = currentState();
+        if (cs->subcaseStack.size() < size_t(cs->subcase_filter_levels)) {
+            if (!cs->filterMatchers[6].matches(m_signature.m_name.c_str(), true))
+                return true;
+            if (cs->filterMatchers[7].matches(m_signature.m_name.c_str(), false))
+                return true;
+        }
+        return false;
+    }
+
+    Subcase::Subcase(const String& name, const char* file, int line)
+            : m_signature({name, file, line}) {
+        ContextState* const cs = currentState();
+        // the subcases are looked up only when discovering the next path to execute - otherwise
+        // they are just compared with the ones on the path
+        if (!cs->reachedLeaf) {
+            const size_t depth = cs->subcaseStack.size();
+            if (cs->nextSubcaseStack.size() <= depth
+                || cs->subcaseTree.is(cs->nextSubcaseStack[depth], m_signature)) {
+                // Going down.
+                if (checkFilters()) { return; }
+
+                cs->subcaseStack.push_back(cs->nextSubcaseStack.size() > depth ?
+                        cs->nextSubcaseStack[depth] :
+                        cs->subcaseTree.node(depth == 0 ? 0 : cs->subcaseStack[depth - 1],
+                                             m_signature));
+                cs->currentSubcaseDepth++;
+                m_entered = true;
+                DOCTEST_ITERATE_THROUGH_REPORTERS(subcase_start, m_signature);
+                startSubcasePerfCounters(cs);
+            }
+        } else {
+            const size_t depth = cs->currentSubcaseDepth;
+            if (depth < cs->subcaseStack.size()
+                && cs->subcaseTree.is(cs->subcaseStack[depth], m_signature)) {
+                // This subcase is reentered via control flow.
+                cs->currentSubcaseDepth++;
+                m_entered = true;
+                DOCTEST_ITERATE_THROUGH_REPORTERS(subcase_start, m_signature);
+                startSubcasePerfCounters(cs);
+            } else if (cs->nextSubcaseStack.size() <= depth) {
+                const unsigned node = cs->subcaseTree.node(
+                        depth == 0 ? 0 : cs->subcaseStack[depth - 1], m_signature);
+                if (cs->subcaseTree.traversed(node)) { return; }
+                if (checkFilters()) { return; }
+                if (cs->discoveredSubcases) {
+                    // executed by another pass - the ones above the forced path are found by others
+                    if (depth >= cs->forcedSubcaseDepth) {
+                        std::vector<SubcaseSignature> path;
+                        for (size_t i = 0; i < depth; ++i)
+                            path.push_back(cs->subcaseTree.signature(cs->subcaseStack[i]));
+                        path.push_back(m_signature);
+                        cs->discoveredSubcases->push_back(std::move(path));
+                    }
+                    cs->subcaseTree.setTraversed(node);
+                    return;
+                }
+                // This subcase is part of the one to be executed next.
+                cs->nextSubcaseStack.assign(cs->subcaseStack.begin(),
+                                            cs->subcaseStack.begin() + depth);
+                cs->nextSubcaseStack.push_back(node);
+            }
+        }
+    }
+
+    DOCTEST_MSVC_SUPPRESS_WARNING_WITH_PUSH(4996) // std::uncaught_exception is deprecated in C++17
+    DOCTEST_GCC_SUPPRESS_WARNING_WITH_PUSH("-Wdeprecated-declarations")
+    DOCTEST_CLANG_SUPPRESS_WARNING_WITH_PUSH("-Wdeprecated-declarations")
+
+    Subcase::~Subcase() {
+        if (m_entered) {
+            ContextState* const cs = currentState();
+            cs->currentSubcaseDepth--;
+
+            deliverThreadLogs(cs);
+
+            if (!cs->reachedLeaf) {
+                // Leaf.
+                cs->subcaseTree.setTraversed(cs->subcaseStack[cs->currentSubcaseDepth]);
+                cs->nextSubcaseStack.clear();
+                cs->reachedLeaf = true;
+            } else if (cs->nextSubcaseStack.empty()) {
+                // All children are finished.
+                cs->subcaseTree.setTraversed(cs->subcaseStack[cs->currentSubcaseDepth]);
+            }
+
+#if defined(__cpp_lib_uncaught_exceptions) && __cpp_lib_uncaught_exceptions >= 201411L && (!defined(__MAC_OS_X_VERSION_MIN_REQUIRED) || __MAC_OS_X_VERSION_MIN_REQUIRED >= 101200)
+            if(std::uncaught_exceptions() > 0
+#else
+            if(std::uncaught_exception()
+#endif
+                && cs->shouldLogCurrentException) {
+                DOCTEST_ITERATE_THROUGH_REPORTERS(
+                        test_case_exception, {"exception thrown in subcase - will translate later "
+                                                "when the whole test case has been exited (cannot "
+                                                "translate while there is an active exception)",
+                                                false});
+                cs->shouldLogCurrentException = false;
+            }
+
+            if(cs->perf_counters && !cs->subcasePerfStack.empty()) {
+                reportPerfCounters(PerfCounterScope::Subcase, m_signature.m_name,
+                                   m_signature.m_file, m_signature.m_line,
+                                   perfCountersSince(cs->subcasePerfStack.back()));
+                cs->subcasePerfStack.pop_back();
+            }
+
+            DOCTEST_ITERATE_THROUGH_REPORTERS(subcase_end, DOCTEST_EMPTY);
+        }
+    }
+
+    DOCTEST_CLANG_SUPPRESS_WARNING_POP
+    DOCTEST_GCC_SUPPRESS_WARNING_POP
+    DOCTEST_MSVC_SUPPRESS_WARNING_POP
+
+    Subcase::operator bool() const { return m_entered; }
+
+    AllocationScope::AllocationScope(const char* file, int line, const char* expr,
+                                     unsigned long long max)
+            : m_file(file)
+            , m_line(line)
+            , m_expr(expr)
+            , m_max(max)
+            , m_start(g_allocations.count) {}
+
+    AllocationScope::~AllocationScope() {
+        const unsigned long long num = g_allocations.count - m_start;
+        decomp_assert(assertType::DT_CHECK, m_file, m_line, m_expr,
+                      Result(num <= m_max, toString(num) + " <= " + toString(m_max)));
+    }
+
+    struct Benchmark::State
+    {
+        BenchmarkStats      stats;
+        std::vector<double> samples; // nanoseconds per iteration
+        unsigned long long  batch = 1;
+        double              warmup_left; // nanoseconds
+        bool                warming_up = true;
+        Timer               timer;
+        bool                perf;               // if the performance counters are measured
+        PerfSample          perfAtStart;        // of the current batch
+        PerfSample          perfTotal = {~0u, {}}; // of the measured batches
+
+        void analyze(int resamples) {
+            std::vector<double> sorted = samples;
+            std::sort(sorted.begin(), sorted.end());
+
+            const auto n = sorted.size();
+
+            double mean = 0;
+            for(auto sample : sorted)
+                mean += sample;
+            mean /= double(n);
+
+            double variance = 0;
+            for(auto sample : sorted)
+                variance += (sample - mean) * (sample - mean);
+
+            stats.m_mean               = mean;
+            stats.m_median             = n % 2 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+            stats.m_standard_deviation = n > 1 ? std::sqrt(variance / double(n - 1)) : 0;
+            stats.m_mean_lower_bound   = mean;
+            stats.m_mean_upper_bound   = mean;
+
+            if(resamples <= 0 || n < 2)
+                return;
+
+            // the means of samples of the same size drawn with replacement - with a fixed seed so
+            // runs are comparable (xorshift instead of std::rand which is used for --order-by=rand)
+            std::vector<double> means(static_cast<unsigned>(resamples));
+            std::uint64_t       rng = 0x9E3779B97F4A7C15ull;
+            for(auto& curr : means) {
+                double sum = 0;
+                for(size_t i = 0; i < n; ++i) {
+                    rng ^= rng << 13;
+                    rng ^= rng >> 7;
+                    rng ^= rng << 17;
+                    sum += sorted[rng % n];
+                }
+                curr = sum / double(n);
+            }
+            std::sort(means.begin(), means.end());
+            stats.m_mean_lower_bound = means[size_t(0.025 * double(means.size()))];
+            stats.m_mean_upper_bound = means[size_t(0.975 * double(means.size() - 1))];
+        }
+    };
+
+    Benchmark::Benchmark(const String& name, const char* file, int line)
+            : m_state(new State()) {
+        const ContextOptions* opt = getContextOptions();
+        m_state->stats.m_name       = name;
+        m_state->stats.m_file       = file;
+        m_state->stats.m_line       = line;
+        m_state->stats.m_samples    = std::max(opt->benchmark_samples, 1);
+        m_state->stats.m_iterations = 0;
+        m_state->warmup_left        = std::max(opt->benchmark_warmup, 0) * 1e6;
+        m_state->perf               = opt->perf_counters;
+        m_state->samples.reserve(unsigned(m_state->stats.m_samples));
+    }
+
+    Benchmark::~Benchmark() { delete m_state; }
+
+    unsigned long long Benchmark::startBatch() {
+        if(m_state->perf)
+            g_perfCounters.sample(m_state->perfAtStart);
+        m_state->timer.start();
+        return m_state->batch;
+    }
+
+    bool Benchmark::endBatch() {
+        State&       st      = *m_state;
+        const double elapsed = double(st.timer.getElapsedNanoseconds());
+        ++m_batches;
+
+        if(st.warming_up) {
+            // keep doubling the size of the batches until one takes long enough (1 ms) for the
+            // resolution of the clock to not matter and then keep going until the warmup is over
+            st.warmup_left -= elapsed;
+            if(elapsed < 1e6)
+                st.batch *= 2;
+            else if(st.warmup_left <= 0)
+                st.warming_up = false;
+            return true;
+        }
+
+        if(st.perf) {
+            PerfSample now;
+            g_perfCounters.sample(now);
+            addPerfCounters(st.perfTotal, st.perfAtStart, now);
+        }
+
+        st.samples.push_back(elapsed / double(st.batch));
+        if(st.samples.size() < unsigned(st.stats.m_samples))
+            return true;
+
+        st.stats.m_iterations = st.batch;
+        st.analyze(getContextOptions()->benchmark_resamples);
+        DOCTEST_ITERATE_THROUGH_REPORTERS(benchmark_end, st.stats);
+        if(st.perf)
+            reportPerfCounters(PerfCounterScope::Benchmark, st.stats.m_name, st.stats.m_file,
+                               st.stats.m_line, st.perfTotal,
+                               double(st.samples.size()) * double(st.batch));
+
+        delete m_state;
+        m_state = nullptr;
+        return false;
+    }
+
+    Result::Result(bool passed)
+            : m_passed(passed) {}
 
     Result::Result(bool passed, const String& decomposition)
             : m_passed(passed)
@@ -1236,6 +2300,7 @@ namespace detail {
         m_no_output         = test_suite.m_no_output;
         m_may_fail          = test_suite.m_may_fail;
         m_should_fail       = test_suite.m_should_fail;
+        m_parallel_subcases = test_suite.m_parallel_subcases;
         m_expected_failures = test_suite.m_expected_failures;
         m_timeout           = test_suite.m_timeout;
 
@@ -1287,11 +2352,168 @@ namespace detail {
         return m_template_id < other.m_template_id;
     }
 
-    // all the registered tests
-    std::set<TestCase>& getRegisteredTests() {
-        static std::set<TestCase> data;
+    // the tests are registered by static initializers so this only appends a plain record to an
+    // array - the strings which don't outlive the registration (the file and the name of templated
+    // test cases) are interned. The TestCase objects given to the reporters are made once when a
+    // test run starts - after sorting the records and dropping the duplicates (a test case in a
+    // header gets registered by every translation unit which includes it)
+    class TestRegistry
+    {
+        struct Record
+        {
+            funcType    test;
+            const char* file; // interned
+            unsigned    line;
+            const char* name; // interned for templated test cases (with the type appended)
+            const char* type; // interned - null for normal test cases
+            int         template_id;
+            TestSuite   data; // the rest of the fields of TestCaseData
+        };
+
+        struct InternedString
+        {
+            const char* str;
+            size_t      len;
+
+            bool operator==(const InternedString& other) const {
+                return len == other.len && std::memcmp(str, other.str, len) == 0;
+            }
+        };
+
+        struct InternedStringHash
+        {
+            DOCTEST_NO_SANITIZE_INTEGER
+            size_t operator()(const InternedString& in) const {
+                size_t res = 5381;
+                for(size_t i = 0; i < in.len; ++i)
+                    res = res * 33 + static_cast<unsigned char>(in.str[i]);
+                return res;
+            }
+        };
+
+        static DOCTEST_CONSTEXPR size_t blockSize = 64 * 1024;
+
+        std::vector<Record>                                          m_records;
+        size_t                                                       m_numFinalized = 0;
+        std::vector<std::vector<char>>                               m_blocks;
+        std::unordered_set<InternedString, InternedStringHash>       m_interned;
+        const char*                                                  m_lastFile = nullptr;
+        std::deque<TestCase>                                         m_tests;
+
+        const char* intern(const char* str) {
+            const InternedString key{str, strlen(str)};
+            auto                 it = m_interned.find(key);
+            if(it != m_interned.end())
+                return it->str;
+
+            if(m_blocks.empty() || m_blocks.back().capacity() - m_blocks.back().size() <= key.len) {
+                m_blocks.emplace_back();
+                m_blocks.back().reserve(key.len < blockSize ? blockSize : key.len + 1);
+            }
+            // the blocks never grow past their capacity so the strings don't move
+            auto& block = m_blocks.back();
+            const char* res = block.data() + block.size();
+            block.insert(block.end(), str, str + key.len + 1);
+
+            m_interned.insert({res, key.len});
+            return res;
+        }
+
+        // the same test case as for TestCase::operator< - the files are interned so their addresses
+        // identify them
+        DOCTEST_NO_SANITIZE_INTEGER
+        static size_t hash(const Record& rec) {
+            size_t res = reinterpret_cast<size_t>(rec.file) ^ (size_t(rec.line) << 8) ^
+                         size_t(rec.template_id);
+            for(const char* c = rec.name; *c; ++c)
+                res = res * 33 + static_cast<unsigned char>(*c);
+            return res;
+        }
+
+        static bool same(const Record& lhs, const Record& rhs) {
+            return lhs.line == rhs.line && lhs.file == rhs.file &&
+                   lhs.template_id == rhs.template_id && std::strcmp(lhs.name, rhs.name) == 0;
+        }
+
+    public:
+        void add(const TestCase& tc) {
+            // consecutive registrations are usually from the same translation unit
+            const char* file = m_lastFile && std::strcmp(m_lastFile, tc.m_file.c_str()) == 0 ?
+                                       m_lastFile :
+                                       intern(tc.m_file.c_str());
+            m_lastFile = file;
+
+            const bool templated = tc.m_template_id != -1;
+
+            Record rec;
+            rec.test                     = tc.m_test;
+            rec.file                     = file;
+            rec.line                     = tc.m_line;
+            rec.name                     = templated ? intern(tc.m_name) : tc.m_name;
+            rec.type                     = templated ? intern(tc.m_type.c_str()) : nullptr;
+            rec.template_id              = tc.m_template_id;
+            rec.data.m_test_suite        = tc.m_test_suite;
+            rec.data.m_description       = tc.m_description;
+            rec.data.m_skip              = tc.m_skip;
+            rec.data.m_no_breaks         = tc.m_no_breaks;
+            rec.data.m_no_output         = tc.m_no_output;
+            rec.data.m_may_fail          = tc.m_may_fail;
+            rec.data.m_should_fail       = tc.m_should_fail;
+            rec.data.m_parallel_subcases = tc.m_parallel_subcases;
+            rec.data.m_expected_failures = tc.m_expected_failures;
+            rec.data.m_timeout           = tc.m_timeout;
+            m_records.push_back(rec);
+        }
+
+        const std::deque<TestCase>& tests() {
+            if(m_numFinalized == m_records.size())
+                return m_tests;
+
+            // the first registration of a duplicate wins and the rest keep the order in which they
+            // were registered - found with an open addressing table of indices of the kept records
+            size_t capacity = 16;
+            while(capacity < m_records.size() * 2)
+                capacity *= 2;
+            const size_t        empty = size_t(-1);
+            std::vector<size_t> table(capacity, empty);
+
+            size_t count = 0;
+            for(size_t i = 0; i < m_records.size(); ++i) {
+                size_t slot = hash(m_records[i]) & (capacity - 1);
+                while(table[slot] != empty && !same(m_records[table[slot]], m_records[i]))
+                    slot = (slot + 1) & (capacity - 1);
+                if(table[slot] != empty)
+                    continue;
+                table[slot]         = count;
+                m_records[count++]  = m_records[i];
+            }
+            m_records.resize(count);
+            m_numFinalized = count;
+
+            m_tests.clear();
+            for(auto& rec : m_records) {
+                m_tests.emplace_back(rec.test, rec.file, rec.line, rec.data,
+                                     rec.type ? String(rec.type) : String(), rec.template_id);
+                TestCase& tc = m_tests.back();
+                if(rec.type) {
+                    // the interned name already has the type appended
+                    tc.m_full_name = rec.name;
+                    tc.m_name      = tc.m_full_name.c_str();
+                } else {
+                    tc.m_name = rec.name;
+                }
+            }
+            return m_tests;
+        }
+    };
+
+    TestRegistry& getTestRegistry() {
+        static TestRegistry data;
         return data;
     }
+
+    // all the registered tests
+    const std::deque<TestCase>& getRegisteredTests() { return getTestRegistry().tests(); }
 } // namespace detail
 namespace {
     using namespace detail;
@@ -1323,13 +2545,29 @@ namespace {
         return suiteOrderComparator(lhs, rhs);
     }
 
+#if defined(DOCTEST_CONFIG_COLORS_ANSI) || defined(DOCTEST_CONFIG_COLORS_WINDOWS)
+    // if stdout is a terminal (-1 until detected) - reset by Context::run() so it is detected once
+    // per run and not with a syscall for every change of the color
+    int g_stdout_is_terminal = -1;
+
+    bool stdoutIsTerminal() {
+        if(g_stdout_is_terminal < 0) {
+#ifdef DOCTEST_CONFIG_COLORS_ANSI
+            g_stdout_is_terminal = isatty(STDOUT_FILENO) ? 1 : 0;
+#else  // DOCTEST_CONFIG_COLORS_ANSI
+            g_stdout_is_terminal = _isatty(_fileno(stdout)) ? 1 : 0;
+#endif // DOCTEST_CONFIG_COLORS_ANSI
+        }
+        return g_stdout_is_terminal == 1;
+    }
+#endif // DOCTEST_CONFIG_COLORS_ANSI || DOCTEST_CONFIG_COLORS_WINDOWS
+
     DOCTEST_CLANG_SUPPRESS_WARNING_WITH_PUSH("-Wdeprecated-declarations")
     void color_to_stream(std::ostream& s, Color::Enum code) {
-        static_cast<void>(s);    // for DOCTEST_CONFIG_COLORS_NONE or DOCTEST_CONFIG_COLORS_WINDOWS
+        static_cast<void>(s);    // for DOCTEST_CONFIG_COLORS_NONE
         static_cast<void>(code); // for DOCTEST_CONFIG_COLORS_NONE
 #ifdef DOCTEST_CONFIG_COLORS_ANSI
-        if(g_no_colors ||
-           (isatty(STDOUT_FILENO) == false && getContextOptions()->force_colors == false))
+        if(g_no_colors || (stdoutIsTerminal() == false && getContextOptions()->force_colors == false))
             return;
 
         auto col = "";
@@ -1355,10 +2593,13 @@ namespace {
 #endif // DOCTEST_CONFIG_COLORS_ANSI
 
 #ifdef DOCTEST_CONFIG_COLORS_WINDOWS
-        if(g_no_colors ||
-           (_isatty(_fileno(stdout)) == false && getContextOptions()->force_colors == false))
+        if(g_no_colors || (stdoutIsTerminal() == false && getContextOptions()->force_colors == false))
             return;
 
+        // the console attributes apply to what is written after they are set - so the text which
+        // the reporters have buffered until now has to be written first
+        s.flush();
+
         static struct ConsoleHelper {
             HANDLE stdoutHandle;
             WORD   origFgAttrs;
@@ -1404,8 +2645,14 @@ namespace {
         return data;
     }
 
+    // translators can be registered from within test cases which might be running in parallel
+    DOCTEST_DECLARE_MUTEX(g_exceptionTranslatorsMutex)
+} // namespace
+
+namespace detail {
     String translateActiveException() {
 #ifndef DOCTEST_CONFIG_NO_EXCEPTIONS
+        DOCTEST_LOCK_MUTEX(g_exceptionTranslatorsMutex)
         String res;
         auto&  translators = getExceptionTranslators();
         for(auto& curr : translators)
@@ -1430,12 +2677,45 @@ namespace {
         return "";
 #endif // DOCTEST_CONFIG_NO_EXCEPTIONS
     }
-} // namespace
 
-namespace detail {
+    // calls the registration functions of the entries in the test section once - ordered by file
+    // and line so TEST_SUITE_BEGIN/TEST_SUITE_END apply to the test cases between them
+    void registerTestSection() {
+#ifdef __ELF__
+        static bool registered = false;
+        const TestSectionEntry* const* begin = __start_doctest_tests;
+        const TestSectionEntry* const* end   = __stop_doctest_tests;
+        if(registered || begin == end)
+            return;
+        registered = true;
+
+        std::vector<const TestSectionEntry*> entries;
+        for(auto it = begin; it != end; ++it)
+            entries.push_back(*it);
+        std::sort(entries.begin(), entries.end(),
+                  [](const TestSectionEntry* lhs, const TestSectionEntry* rhs) {
+                      if(lhs->file != rhs->file) {
+                          const int res = std::strcmp(lhs->file, rhs->file);
+                          if(res != 0)
+                              return res < 0;
+                      }
+                      return lhs->line < rhs->line;
+                  });
+
+        // a test suite block doesn't continue in the next file - this is what the TEST_SUITE_END at
+        // the end of the header does with dynamic initialization but here it's sorted with the header
+        for(size_t i = 0; i < entries.size(); ++i) {
+            if(i == 0 || std::strcmp(entries[i - 1]->file, entries[i]->file) != 0)
+                setTestSuite(TestSuite() * "");
+            entries[i]->reg();
+        }
+        setTestSuite(TestSuite() * "");
+#endif // __ELF__
+    }
+
     // used by the macros for registering tests
     int regTest(const TestCase& tc) {
-        getRegisteredTests().insert(tc);
+        getTestRegistry().add(tc);
         return 0;
     }
 
@@ -1445,8 +2725,30 @@ namespace detail {
         return 0;
     }
 
+    void* findTestCacheValue(const String& type, const String& name) {
+        for(auto& entry : currentState()->testCache)
+            if(entry.type == type && entry.name == name)
+                return entry.value;
+        return nullptr;
+    }
+
+    void addTestCacheValue(const String& type, const String& name, void* value,
+                           void (*destroy)(void*)) {
+        currentState()->testCache.push_back({type, name, value, destroy});
+    }
+
+    bool enterOncePerTest(const String& name) {
+        // the blocks are entries with an empty type name - which no type of test_cache() has
+        const String type;
+        if(findTestCacheValue(type, name))
+            return false;
+        addTestCacheValue(type, name, &currentState()->testCache, nullptr);
+        return true;
+    }
+
+// the (potentially slow) platform-specific check - isDebuggerActive() caches its result
 #ifdef DOCTEST_IS_DEBUGGER_ACTIVE
-    bool isDebuggerActive() { return DOCTEST_IS_DEBUGGER_ACTIVE(); }
+    bool detectDebugger() { return DOCTEST_IS_DEBUGGER_ACTIVE(); }
 #else // DOCTEST_IS_DEBUGGER_ACTIVE
 #ifdef DOCTEST_PLATFORM_LINUX
     class ErrnoGuard {
@@ -1458,7 +2760,7 @@ namespace detail {
     };
     // See the comments in Catch2 for the reasoning behind this implementation:
     // https://github.com/catchorg/Catch2/blob/v2.13.1/include/internal/catch_debugger.cpp#L79-L102
-    bool isDebuggerActive() {
+    bool detectDebugger() {
         ErrnoGuard guard;
         std::ifstream in("/proc/self/status");
         for(std::string line; std::getline(in, line);) {
@@ -1474,7 +2776,7 @@ namespace detail {
     // https://developer.apple.com/library/archive/qa/qa1361/_index.html
     // Returns true if the current process is being debugged (either
     // running under the debugger or has a debugger attached post facto).
-    bool isDebuggerActive() {
+    bool detectDebugger() {
         int        mib[4];
         kinfo_proc info;
         size_t     size;
@@ -1497,19 +2799,92 @@ namespace detail {
         return ((info.kp_proc.p_flag & P_TRACED) != 0);
     }
 #elif DOCTEST_MSVC || defined(__MINGW32__) || defined(__MINGW64__)
-    bool isDebuggerActive() { return ::IsDebuggerPresent() != 0; }
+    bool detectDebugger() { return ::IsDebuggerPresent() != 0; }
 #else
-    bool isDebuggerActive() { return false; }
+    bool detectDebugger() { return false; }
 #endif // Platform
 #endif // DOCTEST_IS_DEBUGGER_ACTIVE
 
+    namespace debuggerCheck {
+        enum Enum
+        {
+            once,   // detect when the test run starts (or on first use) and when asked to
+            always, // detect every time
+            never   // assume that there is no debugger
+        };
+    } // namespace debuggerCheck
+
+    Atomic<int> g_debuggerCheck{debuggerCheck::once};
+    Atomic<int> g_debuggerActive{-1}; // -1 if not detected yet
+
+    bool isDebuggerActive() {
+        const int check = g_debuggerCheck;
+        if(check == debuggerCheck::never)
+            return false;
+        if(check == debuggerCheck::always)
+            return detectDebugger();
+        if(g_debuggerActive < 0)
+            redetectDebugger();
+        return g_debuggerActive != 0;
+    }
+
+    void redetectDebugger() { g_debuggerActive = detectDebugger() ? 1 : 0; }
+
     void registerExceptionTranslatorImpl(const IExceptionTranslator* et) {
+        DOCTEST_LOCK_MUTEX(g_exceptionTranslatorsMutex)
         if(std::find(getExceptionTranslators().begin(), getExceptionTranslators().end(), et) ==
            getExceptionTranslators().end())
             getExceptionTranslators().push_back(et);
     }
 
-    DOCTEST_THREAD_LOCAL std::vector<IContextScope*> g_infoContexts; // for logging with INFO()
+    // the active INFO() contexts of a thread - a trivial type so the thread_local needs no
+    // initialization guard (checked on every access otherwise) and pushing a context is just a
+    // store - only with deeply nested contexts they spill over into an array on the heap
+    struct ContextStack
+    {
+        enum
+        {
+            FixedCapacity = 64
+        };
+
+        IContextScope*  fixed[FixedCapacity];
+        IContextScope** spilled;  // used instead of the fixed array once that is full
+        unsigned        capacity; // of the spilled array
+        unsigned        count;
+
+        unsigned              size() const { return count; }
+        IContextScope* const* data() const { return spilled ? spilled : fixed; }
+
+        void push_back(IContextScope* c) {
+            if(!spilled && count < FixedCapacity)
+                fixed[count++] = c;
+            else
+                spill(c);
+        }
+
+        void pop_back(unsigned num = 1) {
+            count -= num;
+            if(spilled && count == 0) {
+                delete[] spilled;
+                spilled  = nullptr;
+                capacity = 0;
+            }
+        }
+
+        DOCTEST_NOINLINE void spill(IContextScope* c) {
+            if(count == (spilled ? capacity : unsigned(FixedCapacity))) {
+                const unsigned  newCapacity = count * 2;
+                IContextScope** arr         = new IContextScope*[newCapacity];
+                std::copy(data(), data() + count, arr);
+                delete[] spilled;
+                spilled  = arr;
+                capacity = newCapacity;
+            }
+            spilled[count++] = c;
+        }
+    };
+
+    DOCTEST_THREAD_LOCAL ContextStack g_infoContexts; // for logging with INFO()
 
     ContextScopeBase::ContextScopeBase() {
         g_infoContexts.push_back(this);
@@ -1527,19 +2902,29 @@ namespace detail {
     DOCTEST_GCC_SUPPRESS_WARNING_WITH_PUSH("-Wdeprecated-declarations")
     DOCTEST_CLANG_SUPPRESS_WARNING_WITH_PUSH("-Wdeprecated-declarations")
 
+namespace {
+    bool isUnwinding() {
+#if defined(__cpp_lib_uncaught_exceptions) && __cpp_lib_uncaught_exceptions >= 201411L && (!defined(__MAC_OS_X_VERSION_MIN_REQUIRED) || __MAC_OS_X_VERSION_MIN_REQUIRED >= 101200)
+        return std::uncaught_exceptions() > 0;
+#else
+        return std::uncaught_exception();
+#endif
+    }
+
+    // kept out of destroy() so the common case (no exception) doesn't pay for the stream
+    DOCTEST_NOINLINE void stringifyUnwoundContext(const IContextScope* c) {
+        std::ostringstream s;
+        c->stringify(&s);
+        currentState()->stringifiedContexts.push_back(s.str().c_str());
+    }
+} // namespace
+
     // destroy cannot be inlined into the destructor because that would mean calling stringify after
     // ContextScope has been destroyed (base class destructors run after derived class destructors).
     // Instead, ContextScope calls this method directly from its destructor.
     void ContextScopeBase::destroy() {
-#if defined(__cpp_lib_uncaught_exceptions) && __cpp_lib_uncaught_exceptions >= 201411L && (!defined(__MAC_OS_X_VERSION_MIN_REQUIRED) || __MAC_OS_X_VERSION_MIN_REQUIRED >= 101200)
-        if(std::uncaught_exceptions() > 0) {
-#else
-        if(std::uncaught_exception()) {
-#endif
-            std::ostringstream s;
-            this->stringify(&s);
-            g_cs->stringifiedContexts.push_back(s.str().c_str());
-        }
+        if(isUnwinding())
+            stringifyUnwoundContext(this);
         g_infoContexts.pop_back();
     }
 
@@ -1805,12 +3190,12 @@ namespace {
 
     void addAssert(assertType::Enum at) {
         if((at & assertType::is_warn) == 0) //!OCLINT bitwise operator in conditional
-            g_cs->numAssertsCurrentTest_atomic++;
+            currentState()->assertCounters.addAssert();
     }
 
     void addFailedAssert(assertType::Enum at) {
         if((at & assertType::is_warn) == 0) //!OCLINT bitwise operator in conditional
-            g_cs->numAssertsFailedCurrentTest_atomic++;
+            currentState()->assertCounters.addFailedAssert();
     }
 
 #if defined(DOCTEST_CONFIG_POSIX_SIGNALS) || defined(DOCTEST_CONFIG_WINDOWS_SEH)
@@ -1831,36 +3216,240 @@ namespace {
         DOCTEST_ITERATE_THROUGH_REPORTERS(test_run_end, *g_cs);
     }
 #endif // DOCTEST_CONFIG_POSIX_SIGNALS || DOCTEST_CONFIG_WINDOWS_SEH
-} // namespace
 
-AssertData::AssertData(assertType::Enum at, const char* file, int line, const char* expr,
-    const char* exception_type, const StringContains& exception_string)
-    : m_test_case(g_cs->currentTest), m_at(at), m_file(file), m_line(line), m_expr(expr),
-    m_failed(true), m_threw(false), m_threw_as(false), m_exception_type(exception_type),
-    m_exception_string(exception_string) {
-#if DOCTEST_MSVC
-    if (m_expr[0] == ' ') // this happens when variadic macros are disabled under MSVC
-        ++m_expr;
-#endif // MSVC
-}
+#ifdef DOCTEST_WATCHDOG_SIGNAL
+    // the stack of the test case which has been stopped by the watchdog - the number of frames is
+    // set by the signal handler so it also tells that the test case has been stopped
+#ifdef DOCTEST_WATCHDOG_BACKTRACE
+    void* g_frozenFrames[64];
+#endif // DOCTEST_WATCHDOG_BACKTRACE
+    std::atomic<int> g_numFrozenFrames{-1};
+
+    // the handler of the signal with which the watchdog stops a test case - it never returns so the
+    // test case can't continue while its timeout is being reported
+    void freezeTestCase(int) {
+#ifdef DOCTEST_WATCHDOG_BACKTRACE
+        g_numFrozenFrames = backtrace(g_frozenFrames, int(DOCTEST_COUNTOF(g_frozenFrames)));
+#else  // DOCTEST_WATCHDOG_BACKTRACE
+        g_numFrozenFrames = 0;
+#endif // DOCTEST_WATCHDOG_BACKTRACE
+        for(;;)
+            pause();
+    }
+#endif // DOCTEST_WATCHDOG_SIGNAL
+} // namespace
 
+#ifndef DOCTEST_CONFIG_NO_MULTITHREADING
 namespace detail {
-    ResultBuilder::ResultBuilder(assertType::Enum at, const char* file, int line, const char* expr,
-                                 const char* exception_type, const String& exception_string)
-        : AssertData(at, file, line, expr, exception_type, exception_string) { }
+    // enforces the time limits of the test cases run on the main thread when there is a
+    // --test-timeout - a thread sleeps until the deadline of the current test case and if it is
+    // still running then it is stopped, the timeout is reported and the process exits
+    //
+    // the stopped thread might hold the lock of the heap or of a stream so the report can't go
+    // through the reporters - it is formatted when the watchdog gets armed and written with only
+    // async-signal-safe calls (a forked worker writes just the stack since its parent reports it)
+    class Watchdog
+    {
+        DOCTEST_DECLARE_MUTEX(mutex)
+        std::condition_variable               cv;
+        std::thread                           thread;
+        bool                                  armed  = false;
+        bool                                  quit   = false;
+        bool                                  forked = false;
+        std::chrono::steady_clock::time_point deadline;
+        String                                report;
+#if defined(DOCTEST_WATCHDOG_SIGNAL)
+        pthread_t target;
+#elif defined(DOCTEST_PLATFORM_WINDOWS)
+        DWORD target;
+#endif // DOCTEST_WATCHDOG_SIGNAL
+
+        void watch() {
+            g_doctest_thread = true; // reports for the global context
+
+            std::unique_lock<std::mutex> lock(mutex);
+            while(!quit) {
+                if(!armed)
+                    cv.wait(lock);
+                else if(std::chrono::steady_clock::now() < deadline)
+                    cv.wait_until(lock, deadline);
+                else
+                    break;
+            }
+            if(quit)
+                return;
 
-    ResultBuilder::ResultBuilder(assertType::Enum at, const char* file, int line, const char* expr,
-        const char* exception_type, const Contains& exception_string)
-        : AssertData(at, file, line, expr, exception_type, exception_string) { }
+            // the lock is kept so the test case can't disarm the watchdog if it ends meanwhile
+            const int code = forked || !g_cs->no_exitcode ? EXIT_FAILURE : EXIT_SUCCESS;
+            if(!freeze()) {
+                // the test case keeps running so it won't be holding any locks for long
+                std::fprintf(stderr, "%s", report.c_str());
+                std::fprintf(stderr, "[doctest] the test case couldn't be stopped to report it\n");
+                std::_Exit(code);
+            }
 
-    void ResultBuilder::setResult(const Result& res) {
-        m_decomp = res.m_decomp;
-        m_failed = !res.m_passed;
-    }
+            // what has been printed so far - unless the stopped thread is in the middle of it
+#ifdef DOCTEST_WATCHDOG_SIGNAL
+            for(auto stream : {stdout, stderr}) {
+                if(ftrylockfile(stream) == 0) {
+                    std::fflush(stream);
+                    funlockfile(stream);
+                }
+            }
+#endif // DOCTEST_WATCHDOG_SIGNAL
+
+            emit(report.c_str(), report.size());
+#ifdef DOCTEST_WATCHDOG_BACKTRACE
+            // the first frame is the signal handler
+            const int num = g_numFrozenFrames;
+            if(num > 1) {
+                static const char header[] = "stack of the test case:\n";
+                emit(header, sizeof(header) - 1);
+                backtrace_symbols_fd(g_frozenFrames + 1, num - 1, STDERR_FILENO);
+            }
+#endif // DOCTEST_WATCHDOG_BACKTRACE
+            std::_Exit(code);
+        }
 
-    void ResultBuilder::translateException() {
-        m_threw     = true;
-        m_exception = translateActiveException();
+        static void emit(const char* data, size_t size) {
+#ifdef DOCTEST_PLATFORM_WINDOWS
+            DWORD written = 0;
+            WriteFile(GetStdHandle(STD_ERROR_HANDLE), data, DWORD(size), &written, nullptr);
+#else  // DOCTEST_PLATFORM_WINDOWS
+            while(size > 0) {
+                const auto res = ::write(STDERR_FILENO, data, size);
+                if(res < 0 && errno == EINTR)
+                    continue;
+                if(res <= 0)
+                    return;
+                data += res;
+                size -= size_t(res);
+            }
+#endif // DOCTEST_PLATFORM_WINDOWS
+        }
+
+        // stops the thread executing the test case (its stack is captured by the signal handler
+        // where there is backtrace()) - false if it hasn't stopped so it might still be running
+        bool freeze() {
+#if defined(DOCTEST_WATCHDOG_SIGNAL)
+            struct sigaction sa = {};
+            struct sigaction old;
+            sa.sa_handler = freezeTestCase;
+            sigaction(SIGUSR2, &sa, &old);
+            // the test case might have blocked the signal
+            if(pthread_kill(target, SIGUSR2) == 0)
+                for(int i = 0; i < 1000 && g_numFrozenFrames < 0; ++i)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            // a frozen thread stays in the handler - the signal might be used by the tests too
+            sigaction(SIGUSR2, &old, nullptr);
+
+            return g_numFrozenFrames >= 0;
+#elif defined(DOCTEST_PLATFORM_WINDOWS)
+            HANDLE handle = OpenThread(THREAD_SUSPEND_RESUME, FALSE, target);
+            if(!handle)
+                return false;
+            const bool res = SuspendThread(handle) != DWORD(-1);
+            CloseHandle(handle);
+            return res;
+#else  // DOCTEST_WATCHDOG_SIGNAL
+            return false;
+#endif // DOCTEST_WATCHDOG_SIGNAL
+        }
+
+    public:
+        Watchdog() = default;
+        Watchdog(const Watchdog&) = delete;
+        Watchdog& operator=(const Watchdog&) = delete;
+
+        ~Watchdog() {
+            if(!thread.joinable())
+                return;
+            {
+                DOCTEST_LOCK_MUTEX(mutex)
+                quit = true;
+            }
+            cv.notify_one();
+            thread.join();
+        }
+
+        // in a forked worker (see --isolate) the parent reports the test cases which time out
+        void forkedWorker() { forked = true; }
+
+        // called by the thread executing the test case - the watchdog thread starts with the first one
+        void arm(double seconds) {
+            // the only chance to allocate for the report of a timeout
+            String message;
+            if(!forked)
+                message = String("[doctest] the test case \"") + g_cs->currentTest->m_name +
+                          "\" exceeded the time limit of " + toString(seconds) +
+                          " seconds - the test run has been aborted\n";
+            {
+                DOCTEST_LOCK_MUTEX(mutex)
+                report   = std::move(message);
+                deadline = std::chrono::steady_clock::now() +
+                           std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                   std::chrono::duration<double>(seconds));
+#if defined(DOCTEST_WATCHDOG_SIGNAL)
+                target = pthread_self();
+#elif defined(DOCTEST_PLATFORM_WINDOWS)
+                target = GetCurrentThreadId();
+#endif // DOCTEST_WATCHDOG_SIGNAL
+                armed = true;
+                if(!thread.joinable()) {
+#ifdef DOCTEST_WATCHDOG_BACKTRACE
+                    // the first call of backtrace() loads the unwinder (with dlopen() which
+                    // allocates and takes locks) - that can't happen in freezeTestCase() since the
+                    // thread it interrupts might hold those locks and the unwinder stays loaded
+                    void* frame;
+                    backtrace(&frame, 1);
+#endif // DOCTEST_WATCHDOG_BACKTRACE
+                    thread = std::thread([this]() { watch(); });
+                }
+            }
+            cv.notify_one();
+        }
+
+        void disarm() {
+            DOCTEST_LOCK_MUTEX(mutex)
+            armed = false;
+        }
+    };
+} // namespace detail
+#endif // DOCTEST_CONFIG_NO_MULTITHREADING
+
+AssertData::AssertData(assertType::Enum at, const char* file, int line, const char* expr,
+    const char* exception_type, const StringContains& exception_string)
+    : m_test_case(currentState()->currentTest), m_at(at), m_file(file), m_line(line), m_expr(expr),
+    m_failed(true), m_threw(false), m_threw_as(false), m_exception_type(exception_type),
+    m_exception_string(exception_string) {
+#if DOCTEST_MSVC
+    if (m_expr[0] == ' ') // this happens when variadic macros are disabled under MSVC
+        ++m_expr;
+#endif // MSVC
+}
+
+namespace detail {
+    ResultBuilder::ResultBuilder(assertType::Enum at, const char* file, int line, const char* expr,
+                                 const char* exception_type, const String& exception_string)
+        : AssertData(at, file, line, expr, exception_type, exception_string) { }
+
+    ResultBuilder::ResultBuilder(assertType::Enum at, const char* file, int line, const char* expr,
+        const char* exception_type, const Contains& exception_string)
+        : AssertData(at, file, line, expr, exception_type, exception_string) { }
+
+    void ResultBuilder::setResult(const Result& res, bool threw) {
+        if(threw) {
+            m_threw     = true;
+            m_exception = res.m_decomp;
+            return;
+        }
+        m_decomp = res.m_decomp;
+        m_failed = !res.m_passed;
+    }
+
+    void ResultBuilder::translateException() {
+        m_threw     = true;
+        m_exception = translateActiveException();
     }
 
     bool ResultBuilder::log() {
@@ -1881,7 +3470,8 @@ namespace detail {
 
         if(is_running_in_test) {
             addAssert(m_at);
-            DOCTEST_ITERATE_THROUGH_REPORTERS(log_assert, *this);
+            if(!logOnOwnThread(*this))
+                DOCTEST_ITERATE_THROUGH_REPORTERS(log_assert, *this);
 
             if(m_failed)
                 addFailedAssert(m_at);
@@ -1890,7 +3480,7 @@ namespace detail {
         }
 
         return m_failed && isDebuggerActive() && !getContextOptions()->no_breaks &&
-            (g_cs->currentTest == nullptr || !g_cs->currentTest->m_no_breaks); // break into debugger
+            (currentState()->currentTest == nullptr || !currentState()->currentTest->m_no_breaks); // break into debugger
     }
 
     void ResultBuilder::react() const {
@@ -1898,6 +3488,15 @@ namespace detail {
             throwException();
     }
 
+    bool countPassedAssert(assertType::Enum at) {
+        if(!is_running_in_test)
+            return true; // a passing assert outside of a testing context is a no-op
+        if(currentState()->report_successful_asserts)
+            return false;
+        addAssert(at);
+        return true;
+    }
+
     void failed_out_of_a_testing_context(const AssertData& ad) {
         if(g_cs->ah)
             g_cs->ah(ad);
@@ -1938,7 +3537,8 @@ namespace detail {
             logged = true;
         }
 
-        DOCTEST_ITERATE_THROUGH_REPORTERS(log_message, *this);
+        if(!logOnOwnThread(*this))
+            DOCTEST_ITERATE_THROUGH_REPORTERS(log_message, *this);
 
         const bool isWarn = m_severity & assertType::is_warn;
 
@@ -1949,7 +3549,7 @@ namespace detail {
         }
 
         return isDebuggerActive() && !getContextOptions()->no_breaks && !isWarn &&
-            (g_cs->currentTest == nullptr || !g_cs->currentTest->m_no_breaks); // break into debugger
+            (currentState()->currentTest == nullptr || !currentState()->currentTest->m_no_breaks); // break into debugger
     }
 
     void MessageBuilder::react() {
@@ -2503,6 +4103,19 @@ namespace {
                     .writeAttribute("test_case_success", st.testCaseSuccess);
             if(opt.duration)
                 xml.writeAttribute("duration", st.seconds);
+            if(st.allocationsTracked)
+                xml.writeAttribute("allocations", st.numAllocations)
+                        .writeAttribute("allocated_bytes", st.allocatedBytes)
+                        .writeAttribute("peak_allocated_bytes", st.peakAllocatedBytes);
+            if(st.resourcesMeasured)
+                xml.writeAttribute("user_seconds", st.userSeconds)
+                        .writeAttribute("system_seconds", st.systemSeconds)
+                        .writeAttribute("resident_bytes", st.residentBytes)
+                        .writeAttribute("peak_resident_bytes", st.peakResidentBytes)
+                        .writeAttribute("major_faults", st.majorFaults)
+                        .writeAttribute("minor_faults", st.minorFaults)
+                        .writeAttribute("voluntary_context_switches", st.voluntarySwitches)
+                        .writeAttribute("involuntary_context_switches", st.involuntarySwitches);
             if(tc->m_expected_failures)
                 xml.writeAttribute("expected_failures", tc->m_expected_failures);
             xml.endElement();
@@ -2528,6 +4141,8 @@ namespace {
 
         void subcase_end() override { xml.endElement(); }
 
+        bool wants_successful_asserts() const override { return opt.success; }
+
         void log_assert(const AssertData& rb) override {
             if(!rb.m_failed && !opt.success)
                 return;
@@ -2572,6 +4187,44 @@ namespace {
             xml.endElement();
         }
 
+        void benchmark_end(const BenchmarkStats& in) override {
+            DOCTEST_LOCK_MUTEX(mutex)
+
+            xml.startElement("Benchmark")
+                    .writeAttribute("name", in.m_name)
+                    .writeAttribute("filename", skipPathFromFilename(in.m_file))
+                    .writeAttribute("line", line(in.m_line))
+                    .writeAttribute("samples", in.m_samples);
+            if(opt.no_time_in_output == false) {
+                // the durations are in nanoseconds per iteration
+                xml.writeAttribute("iterations", in.m_iterations)
+                        .writeAttribute("mean", in.m_mean)
+                        .writeAttribute("median", in.m_median)
+                        .writeAttribute("standard_deviation", in.m_standard_deviation)
+                        .writeAttribute("mean_lower_bound", in.m_mean_lower_bound)
+                        .writeAttribute("mean_upper_bound", in.m_mean_upper_bound);
+            }
+            xml.endElement();
+        }
+
+        void perf_counters(const PerfCounterStats& in) override {
+            static const char* const names[PerfCounter::Count] = {
+                    "cycles", "instructions", "branch_misses", "cache_misses", "task_clock",
+                    "page_faults"};
+
+            DOCTEST_LOCK_MUTEX(mutex)
+
+            xml.startElement("PerfCounters");
+            if(in.m_scope == PerfCounterScope::Benchmark)
+                xml.writeAttribute("benchmark", in.m_name);
+            // the counters which can be read depend on the machine and their values on the run
+            if(opt.no_time_in_output == false)
+                for(int i = 0; i < PerfCounter::Count; ++i)
+                    if(in.measured(PerfCounter::Enum(i)))
+                        xml.writeAttribute(names[i], in.m_values[i]);
+            xml.endElement();
+        }
+
         void test_case_skipped(const TestCaseData& in) override {
             if(opt.no_skipped_summary == false) {
                 test_case_start_impl(in);
@@ -2689,6 +4342,7 @@ namespace {
                 std::string classname, name;
                 double time;
                 std::vector<JUnitTestMessage> failures, errors;
+                std::vector<std::pair<std::string, std::string>> properties;
             };
 
             void add(const std::string& classname, const std::string& name) {
@@ -2718,6 +4372,10 @@ namespace {
                 ++totalErrors;
             }
 
+            void addProperty(const std::string& name, const std::string& value) {
+                testcases.back().properties.emplace_back(name, value);
+            }
+
             std::vector<JUnitTestCase> testcases;
             double totalSeconds = 0;
             int totalErrors = 0, totalFailures = 0;
@@ -2729,12 +4387,86 @@ namespace {
         const ContextOptions& opt;
         const TestCaseData*   tc = nullptr;
 
-        JUnitReporter(const ContextOptions& co)
+        // when streaming every <testcase> is written as soon as it finishes instead of keeping all
+        // of them in memory until the end - the totals are then patched into space reserved in the
+        // <testsuite> tag (or written in a trailing <testsuite> if the output isn't seekable)
+        bool           streaming;
+        std::streampos totalsPos = -1;
+
+        static DOCTEST_CONSTEXPR int totalsReserved = 128;
+
+        JUnitReporter(const ContextOptions& co, bool stream = false)
                 : xml(*co.cout)
-                , opt(co) {}
+                , opt(co)
+                , streaming(stream) {}
 
         unsigned line(unsigned l) const { return opt.no_line_numbers ? 0 : l; }
 
+        std::string binaryName() const {
+            // remove .exe extension - mainly to have the same output on UNIX and Windows
+            std::string binary_name = skipPathFromFilename(opt.binary_name.c_str());
+#ifdef DOCTEST_PLATFORM_WINDOWS
+            if(binary_name.rfind(".exe") != std::string::npos)
+                binary_name = binary_name.substr(0, binary_name.length() - 4);
+#endif // DOCTEST_PLATFORM_WINDOWS
+            return binary_name;
+        }
+
+        void writeTotals(const TestRunStats& p) {
+            xml.writeAttribute("errors", testCaseData.totalErrors)
+                    .writeAttribute("failures", testCaseData.totalFailures)
+                    .writeAttribute("tests", p.numAsserts);
+            if(opt.no_time_in_output == false)
+                xml.writeAttribute("time", testCaseData.totalSeconds);
+        }
+
+        void writeTestCase(const JUnitTestCaseData::JUnitTestCase& testCase) {
+            xml.startElement("testcase")
+                .writeAttribute("classname", testCase.classname)
+                .writeAttribute("name", testCase.name);
+            if(opt.no_time_in_output == false)
+                xml.writeAttribute("time", testCase.time);
+            // This is not ideal, but it should be enough to mimic gtest's junit output.
+            xml.writeAttribute("status", "run");
+
+            if(!testCase.properties.empty()) {
+                xml.startElement("properties");
+                for(const auto& property : testCase.properties) {
+                    xml.scopedElement("property")
+                        .writeAttribute("name", property.first)
+                        .writeAttribute("value", property.second);
+                }
+                xml.endElement();
+            }
+
+            for(const auto& failure : testCase.failures) {
+                xml.scopedElement("failure")
+                    .writeAttribute("message", failure.message)
+                    .writeAttribute("type", failure.type)
+                    .writeText(failure.details, false);
+            }
+
+            for(const auto& error : testCase.errors) {
+                xml.scopedElement("error")
+                    .writeAttribute("message", error.message)
+                    .writeText(error.details);
+            }
+
+            xml.endElement();
+        }
+
+        // a test case (or one of its traversals of the subcases) has finished
+        void endTestCase() {
+            testCaseData.addTime(timer.getElapsedSeconds());
+            testCaseData.appendSubcaseNamesToLastTestcase(deepestSubcaseStackNames);
+            deepestSubcaseStackNames.clear();
+
+            if(streaming) {
+                writeTestCase(testCaseData.testcases.back());
+                testCaseData.testcases.clear();
+            }
+        }
+
         // =========================================================================================
         // WHAT FOLLOWS ARE OVERRIDES OF THE VIRTUAL METHODS OF THE REPORTER INTERFACE
         // =========================================================================================
@@ -2745,51 +4477,50 @@ namespace {
 
         void test_run_start() override {
             xml.writeDeclaration();
+
+            if(streaming) {
+                xml.startElement("testsuites");
+                xml.startElement("testsuite").writeAttribute("name", binaryName());
+                if(opt.no_time_in_output == false)
+                    xml.writeAttribute("timestamp", JUnitTestCaseData::getCurrentTimestamp());
+                if(opt.no_version == false)
+                    xml.writeAttribute("doctest_version", DOCTEST_VERSION_STR);
+
+                // whitespace inside of the tag keeps the xml valid until the totals get written
+                totalsPos = opt.cout->tellp();
+                if(totalsPos != std::streampos(-1))
+                    *opt.cout << std::string(totalsReserved, ' ');
+            }
         }
 
         void test_run_end(const TestRunStats& p) override {
-            // remove .exe extension - mainly to have the same output on UNIX and Windows
-            std::string binary_name = skipPathFromFilename(opt.binary_name.c_str());
-#ifdef DOCTEST_PLATFORM_WINDOWS
-            if(binary_name.rfind(".exe") != std::string::npos)
-                binary_name = binary_name.substr(0, binary_name.length() - 4);
-#endif // DOCTEST_PLATFORM_WINDOWS
+            if(streaming) {
+                xml.endElement();
+                if(totalsPos == std::streampos(-1)) {
+                    xml.startElement("testsuite").writeAttribute("name", binaryName() + " totals");
+                    writeTotals(p);
+                    xml.endElement();
+                }
+                xml.endElement();
+
+                if(totalsPos != std::streampos(-1)) {
+                    opt.cout->seekp(totalsPos);
+                    writeTotals(p);
+                    opt.cout->seekp(0, std::ios::end);
+                }
+                return;
+            }
+
             xml.startElement("testsuites");
-            xml.startElement("testsuite").writeAttribute("name", binary_name)
-                    .writeAttribute("errors", testCaseData.totalErrors)
-                    .writeAttribute("failures", testCaseData.totalFailures)
-                    .writeAttribute("tests", p.numAsserts);
-            if(opt.no_time_in_output == false) {
-                xml.writeAttribute("time", testCaseData.totalSeconds);
+            xml.startElement("testsuite").writeAttribute("name", binaryName());
+            writeTotals(p);
+            if(opt.no_time_in_output == false)
                 xml.writeAttribute("timestamp", JUnitTestCaseData::getCurrentTimestamp());
-            }
             if(opt.no_version == false)
                 xml.writeAttribute("doctest_version", DOCTEST_VERSION_STR);
 
-            for(const auto& testCase : testCaseData.testcases) {
-                xml.startElement("testcase")
-                    .writeAttribute("classname", testCase.classname)
-                    .writeAttribute("name", testCase.name);
-                if(opt.no_time_in_output == false)
-                    xml.writeAttribute("time", testCase.time);
-                // This is not ideal, but it should be enough to mimic gtest's junit output.
-                xml.writeAttribute("status", "run");
-
-                for(const auto& failure : testCase.failures) {
-                    xml.scopedElement("failure")
-                        .writeAttribute("message", failure.message)
-                        .writeAttribute("type", failure.type)
-                        .writeText(failure.details, false);
-                }
-
-                for(const auto& error : testCase.errors) {
-                    xml.scopedElement("error")
-                        .writeAttribute("message", error.message)
-                        .writeText(error.details);
-                }
-
-                xml.endElement();
-            }
+            for(const auto& testCase : testCaseData.testcases)
+                writeTestCase(testCase);
             xml.endElement();
             xml.endElement();
         }
@@ -2800,18 +4531,34 @@ namespace {
         }
 
         void test_case_reenter(const TestCaseData& in) override {
-            testCaseData.addTime(timer.getElapsedSeconds());
-            testCaseData.appendSubcaseNamesToLastTestcase(deepestSubcaseStackNames);
-            deepestSubcaseStackNames.clear();
+            endTestCase();
 
             timer.start();
             testCaseData.add(skipPathFromFilename(in.m_file.c_str()), in.m_name);
         }
 
-        void test_case_end(const CurrentTestCaseStats&) override {
-            testCaseData.addTime(timer.getElapsedSeconds());
-            testCaseData.appendSubcaseNamesToLastTestcase(deepestSubcaseStackNames);
-            deepestSubcaseStackNames.clear();
+        void test_case_end(const CurrentTestCaseStats& st) override {
+            // the heap usage of the whole test case is a property of its last traversal
+            if(st.allocationsTracked) {
+                testCaseData.addProperty("allocations", std::to_string(st.numAllocations));
+                testCaseData.addProperty("allocated_bytes", std::to_string(st.allocatedBytes));
+                testCaseData.addProperty("peak_allocated_bytes",
+                                         std::to_string(st.peakAllocatedBytes));
+            }
+            if(st.resourcesMeasured) {
+                testCaseData.addProperty("user_seconds", std::to_string(st.userSeconds));
+                testCaseData.addProperty("system_seconds", std::to_string(st.systemSeconds));
+                testCaseData.addProperty("resident_bytes", std::to_string(st.residentBytes));
+                testCaseData.addProperty("peak_resident_bytes",
+                                         std::to_string(st.peakResidentBytes));
+                testCaseData.addProperty("major_faults", std::to_string(st.majorFaults));
+                testCaseData.addProperty("minor_faults", std::to_string(st.minorFaults));
+                testCaseData.addProperty("voluntary_context_switches",
+                                         std::to_string(st.voluntarySwitches));
+                testCaseData.addProperty("involuntary_context_switches",
+                                         std::to_string(st.involuntarySwitches));
+            }
+            endTestCase();
         }
 
         void test_case_exception(const TestCaseException& e) override {
@@ -2825,6 +4572,8 @@ namespace {
 
         void subcase_end() override {}
 
+        bool wants_successful_asserts() const override { return false; }
+
         void log_assert(const AssertData& rb) override {
             if(!rb.m_failed) // report only failures & ignore the `success` option
                 return;
@@ -2857,6 +4606,29 @@ namespace {
                 mb.m_severity & assertType::is_check ? "FAIL_CHECK" : "FAIL", os.str());
         }
 
+        void benchmark_end(const BenchmarkStats& in) override {
+            DOCTEST_LOCK_MUTEX(mutex)
+
+            // junit has no notion of benchmarks so they become properties of the test case
+            const std::string prefix = std::string(in.m_name.c_str()) + ".";
+            const auto        add    = [&](const char* name, double value) {
+                std::ostringstream os;
+                os << value;
+                testCaseData.addProperty(prefix + name, os.str());
+            };
+
+            add("samples", in.m_samples);
+            if(opt.no_time_in_output == false) {
+                // the durations are in nanoseconds per iteration
+                add("iterations", double(in.m_iterations));
+                add("mean", in.m_mean);
+                add("median", in.m_median);
+                add("standard_deviation", in.m_standard_deviation);
+                add("mean_lower_bound", in.m_mean_lower_bound);
+                add("mean_upper_bound", in.m_mean_upper_bound);
+            }
+        }
+
         void test_case_skipped(const TestCaseData&) override {}
 
         void log_contexts(std::ostringstream& s) {
@@ -2876,6 +4648,14 @@ namespace {
 
     DOCTEST_REGISTER_REPORTER("junit", 0, JUnitReporter);
 
+    struct StreamingJUnitReporter : public JUnitReporter
+    {
+        StreamingJUnitReporter(const ContextOptions& co)
+                : JUnitReporter(co, true) {}
+    };
+
+    DOCTEST_REGISTER_REPORTER("junit_streaming", 0, StreamingJUnitReporter);
+
     struct Whitespace
     {
         int nrSpaces;
@@ -2889,9 +4669,67 @@ namespace {
         return out;
     }
 
+    // a duration printed with the most fitting unit
+    struct Nanoseconds
+    {
+        double value;
+    };
+
+    std::ostream& operator<<(std::ostream& out, const Nanoseconds& in) {
+        static const char* const units[] = {"ns", "us", "ms", "s"};
+
+        double value = in.value;
+        unsigned unit = 0;
+        for(; unit < 3 && value >= 1000; ++unit)
+            value /= 1000;
+
+        const auto flags     = out.flags();
+        const auto precision = out.precision();
+        out << std::setprecision(3) << std::fixed << value << " " << units[unit];
+        out.flags(flags);
+        out.precision(precision);
+        return out;
+    }
+
+    // the output of a reporter is assembled here and written to the destination stream at once when
+    // flushed (through std::flush or pubsync()) - the memory is reused for the whole run
+    class OutputBuffer : public std::streambuf
+    {
+        std::ostream&     m_out;
+        std::vector<char> m_data;
+
+    protected:
+        int_type overflow(int_type ch) override {
+            if(!traits_type::eq_int_type(ch, traits_type::eof()))
+                m_data.push_back(traits_type::to_char_type(ch));
+            return traits_type::not_eof(ch);
+        }
+
+        std::streamsize xsputn(const char* str, std::streamsize count) override {
+            m_data.insert(m_data.end(), str, str + count);
+            return count;
+        }
+
+        int sync() override {
+            if(!m_data.empty()) {
+                m_out.write(m_data.data(), static_cast<std::streamsize>(m_data.size()));
+                m_out.flush();
+                m_data.clear();
+            }
+            return 0;
+        }
+
+    public:
+        explicit OutputBuffer(std::ostream& out)
+                : m_out(out) {
+            m_data.reserve(4096);
+        }
+    };
+
     struct ConsoleReporter : public IReporter
     {
-        std::ostream&                 s;
+        OutputBuffer                  buffer;
+        std::ostream                  s;
         bool                          hasLoggedCurrentTestStart;
         std::vector<SubcaseSignature> subcasesStack;
         size_t                        currentSubcaseLevel;
@@ -2901,13 +4739,40 @@ namespace {
         const ContextOptions& opt;
         const TestCaseData*   tc;
 
+        std::vector<std::pair<double, String>> durations; // for --slowest
+        std::vector<std::pair<CurrentTestCaseStats, String>> resources; // for --resource-summary
+
+        // the output of each event is written at once when it ends - but when it goes to a file
+        // (see --out) it isn't mixed with what the tests print so it is written per test case
+        bool perTestCase;
+        bool inTestCase = false;
+
         ConsoleReporter(const ContextOptions& co)
-                : s(*co.cout)
-                , opt(co) {}
+                : buffer(*co.cout)
+                , s(&buffer)
+                , opt(co)
+                , perTestCase(co.out.size() != 0) {}
 
         ConsoleReporter(const ContextOptions& co, std::ostream& ostr)
-                : s(ostr)
-                , opt(co) {}
+                : buffer(ostr)
+                , s(&buffer)
+                , opt(co)
+                , perTestCase(co.out.size() != 0) {}
+
+        ~ConsoleReporter() override { buffer.pubsync(); }
+
+        // declared first in the overrides which print - writes their output when they return
+        struct OutputScope
+        {
+            ConsoleReporter& r;
+
+            ~OutputScope() {
+                if(r.perTestCase && r.inTestCase)
+                    return;
+                DOCTEST_LOCK_MUTEX(r.mutex)
+                r.buffer.pubsync();
+            }
+        };
 
         // =========================================================================================
         // WHAT FOLLOWS ARE HELPERS USED BY THE OVERRIDES OF THE VIRTUAL METHODS OF THE INTERFACE
@@ -3019,6 +4884,10 @@ namespace {
             s << Color::Cyan << "[doctest]\n" << Color::None;
             s << Color::Cyan << "[doctest] " << Color::None;
             s << "filters use wildcards for matching strings\n";
+#ifdef DOCTEST_CONFIG_FILTER_REGEX
+            s << Color::Cyan << "[doctest] " << Color::None;
+            s << "or regular expressions when starting with \"re:\" (not for reporters)\n";
+#endif // DOCTEST_CONFIG_FILTER_REGEX
             s << Color::Cyan << "[doctest] " << Color::None;
             s << "something passes a filter if any of the strings in a filter matches\n";
 #ifndef DOCTEST_CONFIG_NO_UNPREFIXED_OPTIONS
@@ -3066,7 +4935,8 @@ namespace {
               << Whitespace(sizePrefixDisplay*1) << "output filename\n";
             s << " -" DOCTEST_OPTIONS_PREFIX_DISPLAY "ob,  --" DOCTEST_OPTIONS_PREFIX_DISPLAY "order-by=<string>             "
               << Whitespace(sizePrefixDisplay*1) << "how the tests should be ordered\n";
-            s << Whitespace(sizePrefixDisplay*3) << "                                       <string> - [file/suite/name/rand/none]\n";
+            s << Whitespace(sizePrefixDisplay*3) << "                                       <string> - [file/suite/name/rand/none/\n";
+            s << Whitespace(sizePrefixDisplay*3) << "                                       duration]\n";
             s << " -" DOCTEST_OPTIONS_PREFIX_DISPLAY "rs,  --" DOCTEST_OPTIONS_PREFIX_DISPLAY "rand-seed=<int>               "
               << Whitespace(sizePrefixDisplay*1) << "seed for random ordering\n";
             s << " -" DOCTEST_OPTIONS_PREFIX_DISPLAY "f,   --" DOCTEST_OPTIONS_PREFIX_DISPLAY "first=<int>                   "
@@ -3075,10 +4945,42 @@ namespace {
             s << " -" DOCTEST_OPTIONS_PREFIX_DISPLAY "l,   --" DOCTEST_OPTIONS_PREFIX_DISPLAY "last=<int>                    "
               << Whitespace(sizePrefixDisplay*1) << "the last test passing the filters to\n";
             s << Whitespace(sizePrefixDisplay*3) << "                                       execute - for range-based execution\n";
+            s << " -" DOCTEST_OPTIONS_PREFIX_DISPLAY "shc, --" DOCTEST_OPTIONS_PREFIX_DISPLAY "shard-count=<int>             "
+              << Whitespace(sizePrefixDisplay*1) << "split the tests passing the filters into\n";
+            s << Whitespace(sizePrefixDisplay*3) << "                                       <int> shards balanced by their durations\n";
+            s << " -" DOCTEST_OPTIONS_PREFIX_DISPLAY "shi, --" DOCTEST_OPTIONS_PREFIX_DISPLAY "shard-index=<int>             "
+              << Whitespace(sizePrefixDisplay*1) << "the shard to execute (from 0)\n";
             s << " -" DOCTEST_OPTIONS_PREFIX_DISPLAY "aa,  --" DOCTEST_OPTIONS_PREFIX_DISPLAY "abort-after=<int>             "
               << Whitespace(sizePrefixDisplay*1) << "stop after <int> failed assertions\n";
             s << " -" DOCTEST_OPTIONS_PREFIX_DISPLAY "scfl,--" DOCTEST_OPTIONS_PREFIX_DISPLAY "subcase-filter-levels=<int>   "
               << Whitespace(sizePrefixDisplay*1) << "apply filters for the first <int> levels\n";
+            s << " -" DOCTEST_OPTIONS_PREFIX_DISPLAY "par, --" DOCTEST_OPTIONS_PREFIX_DISPLAY "parallel=<int>                "
+              << Whitespace(sizePrefixDisplay*1) << "run the tests on <int> threads\n";
+            s << " -" DOCTEST_OPTIONS_PREFIX_DISPLAY "bms, --" DOCTEST_OPTIONS_PREFIX_DISPLAY "benchmark-samples=<int>       "
+              << Whitespace(sizePrefixDisplay*1) << "samples to measure for each benchmark\n";
+            s << " -" DOCTEST_OPTIONS_PREFIX_DISPLAY "bmr, --" DOCTEST_OPTIONS_PREFIX_DISPLAY "benchmark-resamples=<int>     "
+              << Whitespace(sizePrefixDisplay*1) << "bootstrap resamples for the confidence\n";
+            s << Whitespace(sizePrefixDisplay*3) << "                                       interval of the mean of benchmarks\n";
+            s << " -" DOCTEST_OPTIONS_PREFIX_DISPLAY "bmw, --" DOCTEST_OPTIONS_PREFIX_DISPLAY "benchmark-warmup=<int>        "
+              << Whitespace(sizePrefixDisplay*1) << "milliseconds to run benchmarks before\n";
+            s << Whitespace(sizePrefixDisplay*3) << "                                       measuring them\n";
+            s << " -" DOCTEST_OPTIONS_PREFIX_DISPLAY "dc,  --" DOCTEST_OPTIONS_PREFIX_DISPLAY "debugger-check=<string>       "
+              << Whitespace(sizePrefixDisplay*1) << "when to check if a debugger is attached\n";
+            s << Whitespace(sizePrefixDisplay*3) << "                                       <string> - [once/always/never]\n";
+            s << " -" DOCTEST_OPTIONS_PREFIX_DISPLAY "rp,  --" DOCTEST_OPTIONS_PREFIX_DISPLAY "replay=<string>               "
+              << Whitespace(sizePrefixDisplay*1) << "report the output of the binary reporter\n";
+            s << Whitespace(sizePrefixDisplay*3) << "                                       from this file instead of running tests\n";
+            s << " -" DOCTEST_OPTIONS_PREFIX_DISPLAY "df,  --" DOCTEST_OPTIONS_PREFIX_DISPLAY "durations-file=<string>       "
+              << Whitespace(sizePrefixDisplay*1) << "read and update the durations of the test\n";
+            s << Whitespace(sizePrefixDisplay*3) << "                                       cases from previous runs in this file\n";
+            s << " -" DOCTEST_OPTIONS_PREFIX_DISPLAY "sl,  --" DOCTEST_OPTIONS_PREFIX_DISPLAY "slowest=<int>                 "
+              << Whitespace(sizePrefixDisplay*1) << "print duration percentiles and the <int>\n";
+            s << Whitespace(sizePrefixDisplay*3) << "                                       slowest test cases after the run\n";
+            s << " -" DOCTEST_OPTIONS_PREFIX_DISPLAY "tt,  --" DOCTEST_OPTIONS_PREFIX_DISPLAY "test-timeout=<int>            "
+              << Whitespace(sizePrefixDisplay*1) << "stop the run if a test case takes longer\n";
+            s << Whitespace(sizePrefixDisplay*3) << "                                       than <int> seconds (or its timeout)\n";
+            s << " -" DOCTEST_OPTIONS_PREFIX_DISPLAY "obf, --" DOCTEST_OPTIONS_PREFIX_DISPLAY "out-buffer=<int>              "
+              << Whitespace(sizePrefixDisplay*1) << "the buffer of the --out file in KiB\n";
             s << Color::Cyan << "\n[doctest] " << Color::None;
             s << "Bool options - can be used like flags and true is assumed. Available:\n\n";
             s << " -" DOCTEST_OPTIONS_PREFIX_DISPLAY "s,   --" DOCTEST_OPTIONS_PREFIX_DISPLAY "success=<bool>                "
@@ -3119,6 +5021,20 @@ namespace {
               << Whitespace(sizePrefixDisplay*1) << "whenever file paths start with this prefix, remove it from the output\n";
             s << " -" DOCTEST_OPTIONS_PREFIX_DISPLAY "nln, --" DOCTEST_OPTIONS_PREFIX_DISPLAY "no-line-numbers=<bool>        "
               << Whitespace(sizePrefixDisplay*1) << "0 instead of real line numbers in output\n";
+            s << " -" DOCTEST_OPTIONS_PREFIX_DISPLAY "iso, --" DOCTEST_OPTIONS_PREFIX_DISPLAY "isolate=<bool>                "
+              << Whitespace(sizePrefixDisplay*1) << "parallel workers are forked processes\n";
+            s << " -" DOCTEST_OPTIONS_PREFIX_DISPLAY "res, --" DOCTEST_OPTIONS_PREFIX_DISPLAY "resource-summary=<bool>       "
+              << Whitespace(sizePrefixDisplay*1) << "measure the CPU time, memory, faults and\n";
+            s << Whitespace(sizePrefixDisplay*3) << "                                       context switches of the test cases\n";
+            s << " -" DOCTEST_OPTIONS_PREFIX_DISPLAY "pc,  --" DOCTEST_OPTIONS_PREFIX_DISPLAY "perf-counters=<bool>          "
+              << Whitespace(sizePrefixDisplay*1) << "report the performance counters of test\n";
+            s << Whitespace(sizePrefixDisplay*3) << "                                       cases, subcases and benchmarks\n";
+            s << " -" DOCTEST_OPTIONS_PREFIX_DISPLAY "ar,  --" DOCTEST_OPTIONS_PREFIX_DISPLAY "async-reporters=<bool>        "
+              << Whitespace(sizePrefixDisplay*1) << "format and write the output of the\n";
+            s << Whitespace(sizePrefixDisplay*3) << "                                       reporters on a separate thread\n";
+            s << " -" DOCTEST_OPTIONS_PREFIX_DISPLAY "tl,  --" DOCTEST_OPTIONS_PREFIX_DISPLAY "thread-logs=<bool>            "
+              << Whitespace(sizePrefixDisplay*1) << "report the asserts of threads started by\n";
+            s << Whitespace(sizePrefixDisplay*3) << "                                       tests at the end of the subcase\n";
             // ================================================================================== << 79
             // clang-format on
 
@@ -3145,6 +5061,8 @@ namespace {
         // =========================================================================================
 
         void report_query(const QueryData& in) override {
+            const OutputScope output{*this};
+
             if(opt.version) {
                 printVersion();
             } else if(opt.help) {
@@ -3186,17 +5104,91 @@ namespace {
         }
 
         void test_run_start() override {
+            const OutputScope output{*this};
+
             if(!opt.minimal)
                 printIntro();
         }
 
+        void printSlowest() {
+            std::sort(durations.begin(), durations.end(),
+                      [](const std::pair<double, String>& lhs,
+                         const std::pair<double, String>& rhs) {
+                          return lhs.first > rhs.first;
+                      });
+
+            // nearest-rank percentiles of the durations sorted in descending order
+            auto percentile = [this](double pct) {
+                const auto rank = size_t(std::ceil(pct / 100 * double(durations.size())));
+                return Nanoseconds{durations[durations.size() - std::max(rank, size_t(1))].first * 1e9};
+            };
+
+            s << Color::Cyan << "[doctest] " << Color::None << "durations: p50 " << percentile(50)
+              << " | p90 " << percentile(90) << " | p99 " << percentile(99) << " | max "
+              << Nanoseconds{durations.front().first * 1e9} << "\n";
+            s << Color::Cyan << "[doctest] " << Color::None << "slowest test cases:\n";
+            for(size_t i = 0; i < durations.size() && i < size_t(opt.slowest); ++i)
+                s << Color::Cyan << "[doctest] " << Color::None << std::setw(12)
+                  << Nanoseconds{durations[i].first * 1e9} << "  " << durations[i].second
+                  << "\n";
+        }
+
+        void printResourceSummary() {
+            static const char* const columns[] = {"wall",     "user",  "system", "rss",
+                                                  "peak rss", "major", "minor",  "blocked",
+                                                  "preempted"};
+            static const int         widths[]  = {12, 13, 13, 10, 10, 8, 9, 9, 10};
+
+            // with --no-time-in-output the test cases are in the order of their execution and only
+            // the layout of the table is printed - the measurements differ from run to run
+            if(!opt.no_time_in_output)
+                std::stable_sort(resources.begin(), resources.end(),
+                                 [](const std::pair<CurrentTestCaseStats, String>& lhs,
+                                    const std::pair<CurrentTestCaseStats, String>& rhs) {
+                                     return lhs.first.seconds > rhs.first.seconds;
+                                 });
+
+            s << Color::Cyan << "[doctest] " << Color::None
+              << "resources used by the test cases (the memory is in KiB):\n";
+            s << Color::Cyan << "[doctest] " << Color::None;
+            for(size_t i = 0; i < sizeof(widths) / sizeof(widths[0]); ++i)
+                s << std::setw(widths[i]) << columns[i];
+            s << "  test case\n";
+            for(const auto& curr : resources) {
+                const CurrentTestCaseStats& st = curr.first;
+                s << Color::Cyan << "[doctest] " << Color::None;
+                if(opt.no_time_in_output) {
+                    for(int width : widths)
+                        s << std::setw(width) << "-";
+                } else {
+                    // the durations are followed by a unit which takes 3 characters of the column
+                    s << std::setw(widths[0] - 3) << Nanoseconds{st.seconds * 1e9}
+                      << std::setw(widths[1] - 3) << Nanoseconds{st.userSeconds * 1e9}
+                      << std::setw(widths[2] - 3) << Nanoseconds{st.systemSeconds * 1e9}
+                      << std::setw(widths[3]) << st.residentBytes / 1024 << std::setw(widths[4])
+                      << st.peakResidentBytes / 1024 << std::setw(widths[5]) << st.majorFaults
+                      << std::setw(widths[6]) << st.minorFaults << std::setw(widths[7])
+                      << st.voluntarySwitches << std::setw(widths[8]) << st.involuntarySwitches;
+                }
+                s << "  " << curr.second << "\n";
+            }
+        }
+
         void test_run_end(const TestRunStats& p) override {
+            const OutputScope output{*this};
+
             if(opt.minimal && p.numTestCasesFailed == 0)
                 return;
 
             separator_to_stream();
             s << std::dec;
 
+            if(opt.slowest > 0 && !durations.empty() && !opt.no_time_in_output)
+                printSlowest();
+
+            if(!resources.empty())
+                printResourceSummary();
+
             auto totwidth = int(std::ceil(log10(static_cast<double>(std::max(p.numTestCasesPassingFilters, static_cast<unsigned>(p.numAsserts))) + 1)));
             auto passwidth = int(std::ceil(log10(static_cast<double>(std::max(p.numTestCasesPassingFilters - p.numTestCasesFailed, static_cast<unsigned>(p.numAsserts - p.numAssertsFailed))) + 1)));
             auto failwidth = int(std::ceil(log10(static_cast<double>(std::max(p.numTestCasesFailed, static_cast<unsigned>(p.numAssertsFailed))) + 1)));
@@ -3226,6 +5218,7 @@ namespace {
         }
 
         void test_case_start(const TestCaseData& in) override {
+            inTestCase                = true;
             hasLoggedCurrentTestStart = false;
             tc                        = &in;
             subcasesStack.clear();
@@ -3237,6 +5230,14 @@ namespace {
         }
 
         void test_case_end(const CurrentTestCaseStats& st) override {
+            const OutputScope output{*this};
+            inTestCase = false;
+
+            if(opt.slowest > 0)
+                durations.emplace_back(st.seconds, tc->m_name);
+            if(st.resourcesMeasured)
+                resources.emplace_back(st, tc->m_name);
+
             if(tc->m_no_output)
                 return;
 
@@ -3252,7 +5253,8 @@ namespace {
 
             if(st.failure_flags & TestCaseFailureReason::Timeout)
                 s << Color::Red << "Test case exceeded time limit of " << std::setprecision(6)
-                  << std::fixed << tc->m_timeout << "!\n";
+                  << std::fixed << (tc->m_timeout > 0 ? tc->m_timeout : double(opt.test_timeout))
+                  << "!\n";
 
             if(st.failure_flags & TestCaseFailureReason::ShouldHaveFailedButDidnt) {
                 s << Color::Red << "Should have failed but didn't! Marking it as failed!\n";
@@ -3274,6 +5276,8 @@ namespace {
         }
 
         void test_case_exception(const TestCaseException& e) override {
+            const OutputScope output{*this};
+
             DOCTEST_LOCK_MUTEX(mutex)
             if(tc->m_no_output)
                 return;
@@ -3309,7 +5313,11 @@ namespace {
             hasLoggedCurrentTestStart = false;
         }
 
+        bool wants_successful_asserts() const override { return opt.success; }
+
         void log_assert(const AssertData& rb) override {
+            const OutputScope output{*this};
+
             if((!rb.m_failed && !opt.success) || tc->m_no_output)
                 return;
 
@@ -3326,6 +5334,8 @@ namespace {
         }
 
         void log_message(const MessageData& mb) override {
+            const OutputScope output{*this};
+
             if(tc->m_no_output)
                 return;
 
@@ -3341,6 +5351,30 @@ namespace {
             log_contexts();
         }
 
+        void benchmark_end(const BenchmarkStats& in) override {
+            const OutputScope output{*this};
+
+            if(tc->m_no_output || opt.minimal)
+                return;
+
+            DOCTEST_LOCK_MUTEX(mutex)
+
+            logTestStart();
+
+            file_line_to_stream(in.m_file, in.m_line, " ");
+            s << Color::Cyan << "BENCHMARK: " << Color::None << in.m_name << "\n";
+            s << "  samples: " << in.m_samples;
+            if(opt.no_time_in_output == false) {
+                s << " | iterations: " << in.m_iterations << "\n";
+                s << "  mean: " << Nanoseconds{in.m_mean}
+                  << " | median: " << Nanoseconds{in.m_median}
+                  << " | std dev: " << Nanoseconds{in.m_standard_deviation} << "\n";
+                s << "  95% CI of the mean: [" << Nanoseconds{in.m_mean_lower_bound} << ", "
+                  << Nanoseconds{in.m_mean_upper_bound} << "]";
+            }
+            s << "\n\n";
+        }
+
         void test_case_skipped(const TestCaseData&) override {}
     };
 
@@ -3382,24 +5416,830 @@ namespace {
     DOCTEST_THREAD_LOCAL std::ostringstream DebugOutputWindowReporter::oss;
 #endif // DOCTEST_PLATFORM_WINDOWS
 
-    // the implementation of parseOption()
-    bool parseOptionImpl(int argc, const char* const* argv, const char* pattern, String* value) {
-        // going from the end to the beginning and stopping on the first occurrence from the end
-        for(int i = argc; i > 0; --i) {
-            auto index = i - 1;
-            auto temp = std::strstr(argv[index], pattern);
-            if(temp && (value || strlen(temp) == strlen(pattern))) { //!OCLINT prefer early exits and continue
-                // eliminate matches in which the chars before the option are not '-'
-                bool noBadCharsFound = true;
-                auto curr            = argv[index];
-                while(curr != temp) {
-                    if(*curr++ != '-') {
-                        noBadCharsFound = false;
-                        break;
-                    }
-                }
-                if(noBadCharsFound && argv[index][0] == '-') {
-                    if(value) {
+    // stands in for an INFO() context when recorded events are replayed
+    struct RecordedContextScope : public IContextScope
+    {
+        String str;
+
+        void stringify(std::ostream* s) const override { *s << str; }
+    };
+
+    // the options which decide how the reporters print an event - the test code can change them
+    // through getContextOptions() while it runs so they go along with the events which are
+    // recorded while they differ from those of the state the events are replayed to
+    struct OutputOptions
+    {
+        bool   success              = false;
+        bool   duration             = false;
+        bool   minimal              = false;
+        bool   gnu_file_line        = false;
+        bool   no_path_in_filenames = false;
+        bool   no_line_numbers      = false;
+        bool   no_time_in_output    = false;
+        String strip_file_prefixes;
+
+        OutputOptions() = default;
+
+        explicit OutputOptions(const ContextOptions& in)
+                : success(in.success)
+                , duration(in.duration)
+                , minimal(in.minimal)
+                , gnu_file_line(in.gnu_file_line)
+                , no_path_in_filenames(in.no_path_in_filenames)
+                , no_line_numbers(in.no_line_numbers)
+                , no_time_in_output(in.no_time_in_output)
+                , strip_file_prefixes(in.strip_file_prefixes) {}
+
+        bool sameAs(const ContextOptions& in) const {
+            return success == in.success && duration == in.duration && minimal == in.minimal &&
+                   gnu_file_line == in.gnu_file_line &&
+                   no_path_in_filenames == in.no_path_in_filenames &&
+                   no_line_numbers == in.no_line_numbers &&
+                   no_time_in_output == in.no_time_in_output &&
+                   strip_file_prefixes == in.strip_file_prefixes;
+        }
+
+        void applyTo(ContextOptions& out) const {
+            out.success              = success;
+            out.duration             = duration;
+            out.minimal              = minimal;
+            out.gnu_file_line        = gnu_file_line;
+            out.no_path_in_filenames = no_path_in_filenames;
+            out.no_line_numbers      = no_line_numbers;
+            out.no_time_in_output    = no_time_in_output;
+            out.strip_file_prefixes  = strip_file_prefixes;
+        }
+    };
+
+    // a reporter event which can be delivered to any reporter later - see replay()
+    struct RecordedEvent
+    {
+        std::function<void(IReporter*)> report;
+
+        std::vector<String> contexts;    // the active INFO() contexts at the time of the event
+        std::vector<String> stringified; // contexts stringified due to an exception
+
+        bool          withOptions = false; // the test code had changed the options - see below
+        OutputOptions options;             // in effect while the event gets delivered
+    };
+
+    // the reporters print the contexts of a passing assert only with --success - otherwise they
+    // aren't stringified for it on the thread of the test code when the event is recorded
+    bool withAssertContexts(const AssertData& in) {
+        return in.m_failed || getContextOptions()->success;
+    }
+
+    // delivers a recorded event to the reporters of the context with its contexts restored
+    void replay(ContextState* p, const RecordedEvent& e) {
+        std::vector<RecordedContextScope> scopes(e.contexts.size());
+        for(size_t i = 0; i < scopes.size(); ++i) {
+            scopes[i].str = e.contexts[i];
+            g_infoContexts.push_back(&scopes[i]);
+        }
+        p->stringifiedContexts = e.stringified;
+
+        OutputOptions prev;
+        if(e.withOptions) {
+            prev = OutputOptions(*p);
+            e.options.applyTo(*p);
+        }
+
+        for(auto& curr_rep : p->reporters_currently_used)
+            e.report(curr_rep);
+
+        if(e.withOptions)
+            prev.applyTo(*p);
+        g_infoContexts.pop_back(static_cast<unsigned>(scopes.size()));
+    }
+
+    namespace binaryEvent {
+        enum Enum
+        {
+            TestRunStart,
+            TestRunEnd,
+            TestCaseStart,
+            TestCaseReenter,
+            TestCaseEnd,
+            TestCaseException,
+            SubcaseStart,
+            SubcaseEnd,
+            LogAssert,
+            LogMessage,
+            BenchmarkEnd,
+            TestCaseSkipped,
+            PerfCounters,
+            Options // the options of the events which follow - see OutputOptions
+        };
+    } // namespace binaryEvent
+
+    // written at the start of the output of the binary reporter
+    const char binaryStreamMagic[] = "doctest binary stream 6\n";
+
+    // serializes the reporter events in a compact binary form: every message is a size followed by
+    // the type, the active contexts and the fields of the event - all in the native byte order so
+    // the stream can be read only on the same platform (see BinaryReader)
+    struct BinaryWriter : public IReporter
+    {
+        std::string buf;
+        size_t      msg = 0;
+        size_t      maxBuffered = 65536; // bytes of messages after which they're handed over
+        bool        withTestCases; // whether the data of the test cases is part of the stream
+
+        const ContextOptions* options; // of the test code - sent again whenever they change
+        OutputOptions         sent;
+
+        DOCTEST_DECLARE_MUTEX(mutex)
+
+        BinaryWriter(bool withTestCaseData, const ContextOptions& co)
+                : withTestCases(withTestCaseData)
+                , options(&co)
+                , sent(co) {}
+
+        // hands the buffered messages over - called between messages only
+        virtual void flush() = 0;
+
+        template <typename T>
+        void put(const T& in) {
+            buf.append(reinterpret_cast<const char*>(&in), sizeof(in));
+        }
+
+        void putStr(const char* in) {
+            const unsigned size = in ? unsigned(std::strlen(in)) : UINT_MAX;
+            put(size);
+            if(in)
+                buf.append(in, size);
+        }
+
+        void putTestCase(const TestCaseData& in) {
+            if(!withTestCases)
+                return;
+            putStr(in.m_file.c_str());
+            put(in.m_line);
+            putStr(in.m_name);
+            putStr(in.m_test_suite);
+            putStr(in.m_description);
+            put(in.m_skip);
+            put(in.m_no_breaks);
+            put(in.m_no_output);
+            put(in.m_may_fail);
+            put(in.m_should_fail);
+            put(in.m_parallel_subcases);
+            put(in.m_expected_failures);
+            put(in.m_timeout);
+        }
+
+        void begin(binaryEvent::Enum type, bool withContexts = true) {
+            if(type != binaryEvent::Options && !sent.sameAs(*options)) {
+                sent = OutputOptions(*options);
+                begin(binaryEvent::Options, false);
+                put(sent.success);
+                put(sent.duration);
+                put(sent.minimal);
+                put(sent.gnu_file_line);
+                put(sent.no_path_in_filenames);
+                put(sent.no_line_numbers);
+                put(sent.no_time_in_output);
+                putStr(sent.strip_file_prefixes.c_str());
+                end();
+            }
+            msg = buf.size();
+            put(unsigned(0));
+            put(char(type));
+            put(unsigned(withContexts ? get_num_active_contexts() : 0));
+            for(int i = 0; withContexts && i < get_num_active_contexts(); ++i) {
+                std::ostringstream s;
+                get_active_contexts()[i]->stringify(&s);
+                putStr(s.str().c_str());
+            }
+        }
+
+        void end() {
+            const unsigned size = unsigned(buf.size() - msg - sizeof(unsigned));
+            std::memcpy(&buf[msg], &size, sizeof(size));
+            // don't let a test case with lots of asserts pile up everything in memory
+            if(buf.size() > maxBuffered)
+                flush();
+        }
+
+        void report_query(const QueryData&) override {}
+
+        void test_run_start() override {
+            begin(binaryEvent::TestRunStart, false);
+            end();
+        }
+
+        void test_run_end(const TestRunStats& in) override {
+            begin(binaryEvent::TestRunEnd, false);
+            put(in.numTestCases);
+            put(in.numTestCasesPassingFilters);
+            put(in.numTestSuitesPassingFilters);
+            put(in.numTestCasesFailed);
+            put(in.numAsserts);
+            put(in.numAssertsFailed);
+            end();
+            flush();
+        }
+
+        void test_case_start(const TestCaseData& in) override {
+            begin(binaryEvent::TestCaseStart, false);
+            putTestCase(in);
+            end();
+        }
+
+        void test_case_reenter(const TestCaseData&) override {
+            begin(binaryEvent::TestCaseReenter, false);
+            end();
+        }
+
+        void test_case_end(const CurrentTestCaseStats& in) override {
+            begin(binaryEvent::TestCaseEnd, false);
+            put(in.numAssertsCurrentTest);
+            put(in.numAssertsFailedCurrentTest);
+            put(in.seconds);
+            put(in.failure_flags);
+            put(in.testCaseSuccess);
+            put(in.allocationsTracked);
+            put(in.numAllocations);
+            put(in.allocatedBytes);
+            put(in.peakAllocatedBytes);
+            put(in.resourcesMeasured);
+            put(in.userSeconds);
+            put(in.systemSeconds);
+            put(in.residentBytes);
+            put(in.peakResidentBytes);
+            put(in.majorFaults);
+            put(in.minorFaults);
+            put(in.voluntarySwitches);
+            put(in.involuntarySwitches);
+            end();
+            flush();
+        }
+
+        void test_case_exception(const TestCaseException& in) override {
+            DOCTEST_LOCK_MUTEX(mutex)
+
+            begin(binaryEvent::TestCaseException);
+            putStr(in.error_string.c_str());
+            put(in.is_crash);
+            put(unsigned(get_num_stringified_contexts()));
+            for(int i = 0; i < get_num_stringified_contexts(); ++i)
+                putStr(get_stringified_contexts()[i].c_str());
+            end();
+        }
+
+        void subcase_start(const SubcaseSignature& in) override {
+            begin(binaryEvent::SubcaseStart, false);
+            putStr(in.m_name.c_str());
+            putStr(in.m_file);
+            put(in.m_line);
+            end();
+        }
+
+        void subcase_end() override {
+            begin(binaryEvent::SubcaseEnd, false);
+            end();
+        }
+
+        void log_assert(const AssertData& in) override {
+            DOCTEST_LOCK_MUTEX(mutex)
+
+            begin(binaryEvent::LogAssert, withAssertContexts(in));
+            put(int(in.m_at));
+            putStr(in.m_file);
+            put(in.m_line);
+            putStr(in.m_expr);
+            put(in.m_failed);
+            put(in.m_threw);
+            putStr(in.m_exception.c_str());
+            putStr(in.m_decomp.c_str());
+            put(in.m_threw_as);
+            putStr(in.m_exception_type);
+            putStr(in.m_exception_string.c_str());
+            end();
+        }
+
+        void log_message(const MessageData& in) override {
+            DOCTEST_LOCK_MUTEX(mutex)
+
+            begin(binaryEvent::LogMessage);
+            putStr(in.m_string.c_str());
+            putStr(in.m_file);
+            put(in.m_line);
+            put(int(in.m_severity));
+            end();
+        }
+
+        void benchmark_end(const BenchmarkStats& in) override {
+            begin(binaryEvent::BenchmarkEnd, false);
+            putStr(in.m_name.c_str());
+            putStr(in.m_file);
+            put(in.m_line);
+            put(in.m_samples);
+            put(in.m_iterations);
+            put(in.m_mean);
+            put(in.m_median);
+            put(in.m_standard_deviation);
+            put(in.m_mean_lower_bound);
+            put(in.m_mean_upper_bound);
+            end();
+        }
+
+        void perf_counters(const PerfCounterStats& in) override {
+            begin(binaryEvent::PerfCounters, false);
+            put(int(in.m_scope));
+            putStr(in.m_name.c_str());
+            putStr(in.m_file);
+            put(in.m_line);
+            put(in.m_measured);
+            for(auto value : in.m_values)
+                put(value);
+            end();
+        }
+
+        void test_case_skipped(const TestCaseData& in) override {
+            begin(binaryEvent::TestCaseSkipped, false);
+            putTestCase(in);
+            end();
+        }
+    };
+
+    // a test case read from a binary stream - owns the strings the data points to
+    struct ReplayedTestCase : public TestCaseData
+    {
+        String name, suite, description;
+    };
+
+    // turns the messages of BinaryWriter back into events - nothing which comes from the stream is
+    // trusted: the reads are checked against the end of the message and so is the order of events
+    struct BinaryReader
+    {
+        const char* pos = nullptr;
+        const char* end = nullptr; // of the message which is being decoded
+        bool        bad = false;   // the message is shorter than its fields or out of order
+
+        // the events seen so far - the reporters rely on them coming in the order they are sent
+        bool     runStarted   = false; // the stream of a worker (without test cases) has no start
+        bool     inTestCase   = false;
+        unsigned subcaseDepth = 0;
+
+        // the test case the events refer to - replaced by the test case events when the stream
+        // carries the data of the test cases (and set by the user of the reader otherwise)
+        const TestCaseData*          tc = nullptr;
+        bool                         withTestCases;
+        std::deque<ReplayedTestCase> testCases; // the addresses are stable for the reporters
+
+        CurrentTestCaseStats testCaseStats{}; // of the last test case which ended
+        TestRunStats         runStats{};      // tallied from the events until the end of the run
+        int                  numAssertsFailed = 0;
+
+        bool          withOptions = false; // the last options in the stream - for the next events
+        OutputOptions options;
+
+        explicit BinaryReader(bool withTestCaseData)
+                : withTestCases(withTestCaseData) {}
+
+        // marks the message as malformed if there are fewer bytes left in it
+        bool has(size_t size) {
+            if(!bad && size_t(end - pos) < size)
+                bad = true;
+            return !bad;
+        }
+
+        template <typename T>
+        T get() {
+            T res{};
+            if(!has(sizeof(res)))
+                return res;
+            std::memcpy(&res, pos, sizeof(res));
+            pos += sizeof(res);
+            return res;
+        }
+
+        // not every byte is a valid bool
+        bool getBool() { return get<char>() != 0; }
+
+        // the number of strings which follow - each of them takes at least the size of its length
+        unsigned getCount() {
+            const auto count = get<unsigned>();
+            if(!bad && count > size_t(end - pos) / sizeof(unsigned))
+                bad = true;
+            return bad ? 0 : count;
+        }
+
+        // returns false for a null string
+        bool getStr(String& out) {
+            const auto size = get<unsigned>();
+            if(size == UINT_MAX || !has(size)) {
+                out = String();
+                return false;
+            }
+            out = String(pos, size);
+            pos += size;
+            return true;
+        }
+
+        String getStr() {
+            String res;
+            getStr(res);
+            return res;
+        }
+
+        void getTestCase() {
+            if(!withTestCases)
+                return;
+            testCases.emplace_back();
+            ReplayedTestCase& curr = testCases.back();
+            curr.m_file            = getStr();
+            curr.m_line            = get<unsigned>();
+            curr.name              = getStr();
+            curr.suite             = getStr();
+            const bool has_desc    = getStr(curr.description);
+            curr.m_name            = curr.name.c_str();
+            curr.m_test_suite      = curr.suite.c_str();
+            curr.m_description     = has_desc ? curr.description.c_str() : nullptr;
+            curr.m_skip            = getBool();
+            curr.m_no_breaks       = getBool();
+            curr.m_no_output       = getBool();
+            curr.m_may_fail        = getBool();
+            curr.m_should_fail     = getBool();
+            curr.m_parallel_subcases = getBool();
+            curr.m_expected_failures = get<int>();
+            curr.m_timeout           = get<double>();
+            tc                       = &curr;
+        }
+
+        // decodes the message of the given size at `data` (right after its size) - returns false if
+        // it is malformed or out of order (then `e` shouldn't be used)
+        bool decode(const char* data, size_t size, RecordedEvent& e, binaryEvent::Enum& type) {
+            pos  = data;
+            end  = data + size;
+            bad  = false;
+            const auto rawEvent = static_cast<unsigned char>(get<char>());
+            type = binaryEvent::Enum(rawEvent <= binaryEvent::Options ? rawEvent : 0);
+            if(!bad && (rawEvent > binaryEvent::Options || !isExpected(type)))
+                bad = true;
+            e.contexts.resize(getCount());
+            for(auto& curr : e.contexts)
+                getStr(curr);
+            if(bad)
+                return false;
+
+            // a malformed message leaves the state of the reader as it was
+            const TestRunStats  runStatsBefore         = runStats;
+            const int           numAssertsFailedBefore = numAssertsFailed;
+            const size_t        numTestCasesBefore     = testCases.size();
+            const TestCaseData* tcBefore               = tc;
+
+            switch(type) {
+                case binaryEvent::TestRunStart:
+                    e.report = [](IReporter* r) { r->test_run_start(); };
+                    break;
+                case binaryEvent::TestRunEnd: {
+                    runStats.numTestCases                = get<unsigned>();
+                    runStats.numTestCasesPassingFilters  = get<unsigned>();
+                    runStats.numTestSuitesPassingFilters = get<unsigned>();
+                    runStats.numTestCasesFailed          = get<unsigned>();
+                    runStats.numAsserts                  = get<int>();
+                    runStats.numAssertsFailed            = get<int>();
+                    const TestRunStats st                = runStats;
+                    e.report = [st](IReporter* r) { r->test_run_end(st); };
+                    break;
+                }
+                case binaryEvent::TestCaseStart: {
+                    getTestCase();
+                    runStats.numTestCases++;
+                    runStats.numTestCasesPassingFilters++;
+                    const TestCaseData* curr = tc;
+                    e.report = [curr](IReporter* r) { r->test_case_start(*curr); };
+                    break;
+                }
+                case binaryEvent::TestCaseReenter: {
+                    const TestCaseData* curr = tc;
+                    e.report = [curr](IReporter* r) { r->test_case_reenter(*curr); };
+                    break;
+                }
+                case binaryEvent::TestCaseEnd: {
+                    CurrentTestCaseStats& st       = testCaseStats;
+                    st.numAssertsCurrentTest       = get<int>();
+                    st.numAssertsFailedCurrentTest = get<int>();
+                    st.seconds                     = get<double>();
+                    st.failure_flags               = get<int>();
+                    st.testCaseSuccess             = getBool();
+                    st.allocationsTracked          = getBool();
+                    st.numAllocations              = get<unsigned long long>();
+                    st.allocatedBytes              = get<unsigned long long>();
+                    st.peakAllocatedBytes          = get<unsigned long long>();
+                    st.resourcesMeasured           = getBool();
+                    st.userSeconds                 = get<double>();
+                    st.systemSeconds               = get<double>();
+                    st.residentBytes               = get<long long>();
+                    st.peakResidentBytes           = get<long long>();
+                    st.majorFaults                 = get<unsigned long long>();
+                    st.minorFaults                 = get<unsigned long long>();
+                    st.voluntarySwitches           = get<unsigned long long>();
+                    st.involuntarySwitches         = get<unsigned long long>();
+                    runStats.numTestCasesFailed += st.testCaseSuccess ? 0 : 1;
+                    runStats.numAsserts += st.numAssertsCurrentTest;
+                    runStats.numAssertsFailed += st.numAssertsFailedCurrentTest;
+                    const CurrentTestCaseStats copy = st;
+                    e.report = [copy](IReporter* r) { r->test_case_end(copy); };
+                    break;
+                }
+                case binaryEvent::TestCaseException: {
+                    TestCaseException ex;
+                    ex.error_string = getStr();
+                    ex.is_crash     = getBool();
+                    e.stringified.resize(getCount());
+                    for(auto& curr : e.stringified)
+                        getStr(curr);
+                    e.report = [ex](IReporter* r) { r->test_case_exception(ex); };
+                    break;
+                }
+                case binaryEvent::SubcaseStart: {
+                    const String name = getStr();
+                    const String file = getStr();
+                    const int    line = get<int>();
+                    e.report = [name, file, line](IReporter* r) {
+                        r->subcase_start({name, file.c_str(), line});
+                    };
+                    break;
+                }
+                case binaryEvent::SubcaseEnd:
+                    e.report = [](IReporter* r) { r->subcase_end(); };
+                    break;
+                case binaryEvent::LogAssert: {
+                    const int  rawType = get<int>();
+                    const auto at      = assertType::Enum(assertTypeName(rawType) ? rawType : 0);
+                    String     file, expr, exception, decomp, exception_type, exception_string;
+                    getStr(file);
+                    const int  line     = get<int>();
+                    const bool has_expr = getStr(expr);
+                    const bool failed   = getBool();
+                    const bool threw    = getBool();
+                    getStr(exception);
+                    getStr(decomp);
+                    const bool threw_as = getBool();
+                    const bool has_type = getStr(exception_type);
+                    getStr(exception_string);
+
+                    if(!assertTypeName(rawType))
+                        bad = true;
+                    if(failed && !(at & assertType::is_warn))
+                        numAssertsFailed++;
+
+                    const TestCaseData* curr = tc;
+                    e.report = [=](IReporter* r) {
+                        AssertData ad(at, file.c_str(), line, has_expr ? expr.c_str() : nullptr,
+                                      has_type ? exception_type.c_str() : nullptr,
+                                      exception_string);
+                        ad.m_test_case = curr;
+                        ad.m_failed    = failed;
+                        ad.m_threw     = threw;
+                        ad.m_exception = exception;
+                        ad.m_decomp    = decomp;
+                        ad.m_threw_as  = threw_as;
+                        r->log_assert(ad);
+                    };
+                    break;
+                }
+                case binaryEvent::LogMessage: {
+                    const String str  = getStr();
+                    const String file = getStr();
+                    const int    line = get<int>();
+                    const int    rawSeverity = get<int>();
+                    if(rawSeverity != assertType::is_warn && rawSeverity != assertType::is_check &&
+                       rawSeverity != assertType::is_require)
+                        bad = true;
+                    const auto sev = assertType::Enum(bad ? assertType::is_warn : rawSeverity);
+                    e.report = [str, file, line, sev](IReporter* r) {
+                        r->log_message({str, file.c_str(), line, sev});
+                    };
+                    break;
+                }
+                case binaryEvent::BenchmarkEnd: {
+                    BenchmarkStats st;
+                    st.m_name               = getStr();
+                    const String file       = getStr();
+                    st.m_line               = get<int>();
+                    st.m_samples            = get<int>();
+                    st.m_iterations         = get<unsigned long long>();
+                    st.m_mean               = get<double>();
+                    st.m_median             = get<double>();
+                    st.m_standard_deviation = get<double>();
+                    st.m_mean_lower_bound   = get<double>();
+                    st.m_mean_upper_bound   = get<double>();
+                    e.report = [st, file](IReporter* r) {
+                        BenchmarkStats curr = st;
+                        curr.m_file         = file.c_str();
+                        r->benchmark_end(curr);
+                    };
+                    break;
+                }
+                case binaryEvent::PerfCounters: {
+                    PerfCounterStats st;
+                    const int rawScope = get<int>();
+                    if(rawScope < PerfCounterScope::TestCase || rawScope > PerfCounterScope::Benchmark)
+                        bad = true;
+                    st.m_scope      = PerfCounterScope::Enum(bad ? 0 : rawScope);
+                    st.m_name       = getStr();
+                    const String file = getStr();
+                    st.m_line       = get<int>();
+                    st.m_measured   = get<unsigned>();
+                    for(auto& value : st.m_values)
+                        value = get<double>();
+                    e.report = [st, file](IReporter* r) {
+                        PerfCounterStats curr = st;
+                        curr.m_file           = file.c_str();
+                        r->perf_counters(curr);
+                    };
+                    break;
+                }
+                case binaryEvent::TestCaseSkipped: {
+                    getTestCase();
+                    runStats.numTestCases++;
+                    const TestCaseData* curr = tc;
+                    e.report = [curr](IReporter* r) { r->test_case_skipped(*curr); };
+                    break;
+                }
+                case binaryEvent::Options: {
+                    OutputOptions& curr       = e.options;
+                    curr.success              = getBool();
+                    curr.duration             = getBool();
+                    curr.minimal              = getBool();
+                    curr.gnu_file_line        = getBool();
+                    curr.no_path_in_filenames = getBool();
+                    curr.no_line_numbers      = getBool();
+                    curr.no_time_in_output    = getBool();
+                    getStr(curr.strip_file_prefixes);
+                    e.report = [](IReporter*) {};
+                    break;
+                }
+            }
+            if(bad) {
+                runStats         = runStatsBefore;
+                numAssertsFailed = numAssertsFailedBefore;
+                testCases.resize(numTestCasesBefore);
+                tc = tcBefore;
+                return false;
+            }
+
+            switch(type) {
+                case binaryEvent::TestRunStart: runStarted = true; break;
+                case binaryEvent::TestCaseStart: inTestCase = true; subcaseDepth = 0; break;
+                case binaryEvent::TestCaseReenter: subcaseDepth = 0; break;
+                case binaryEvent::TestCaseEnd: inTestCase = false; break;
+                case binaryEvent::SubcaseStart: ++subcaseDepth; break;
+                case binaryEvent::SubcaseEnd: --subcaseDepth; break;
+                case binaryEvent::Options:
+                    withOptions = true;
+                    options     = e.options;
+                    return true;
+                default: break;
+            }
+            e.withOptions = withOptions;
+            e.options     = options;
+            return true;
+        }
+
+        // whether an event of this type may come next
+        bool isExpected(binaryEvent::Enum type) const {
+            if(type == binaryEvent::TestRunStart)
+                return !runStarted && withTestCases;
+            if(!runStarted && withTestCases)
+                return false;
+            switch(type) {
+                case binaryEvent::TestRunStart:
+                case binaryEvent::TestRunEnd:
+                case binaryEvent::Options: return true;
+                case binaryEvent::TestCaseStart:
+                case binaryEvent::TestCaseSkipped: return !inTestCase;
+                case binaryEvent::SubcaseEnd: return inTestCase && subcaseDepth > 0;
+                case binaryEvent::TestCaseReenter:
+                case binaryEvent::TestCaseEnd:
+                case binaryEvent::TestCaseException:
+                case binaryEvent::SubcaseStart:
+                case binaryEvent::LogAssert:
+                case binaryEvent::LogMessage:
+                case binaryEvent::BenchmarkEnd:
+                case binaryEvent::PerfCounters: return inTestCase && tc;
+            }
+            return false;
+        }
+    };
+
+    // writes the events to the output stream as they happen so nothing is lost if the process
+    // dies - the stream can be turned into the output of any other reporter later with --replay
+    struct BinaryReporter : public BinaryWriter
+    {
+        std::ostream& s;
+
+        bool success;
+
+        explicit BinaryReporter(const ContextOptions& co)
+                : BinaryWriter(true, co)
+                , s(*co.cout)
+                , success(co.success) {}
+
+        // the same passing asserts as the console reporter would print with these options
+        bool wants_successful_asserts() const override { return success; }
+
+        void flush() override {
+            s.write(buf.data(), std::streamsize(buf.size()));
+            s.flush();
+            buf.clear();
+        }
+
+        void test_run_start() override {
+            s << binaryStreamMagic;
+            BinaryWriter::test_run_start();
+        }
+
+        void log_assert(const AssertData& in) override {
+            if(!in.m_failed && !success)
+                return;
+            BinaryWriter::log_assert(in);
+        }
+    };
+
+    DOCTEST_REGISTER_REPORTER("binary", 0, BinaryReporter);
+
+    // feeds the output of the binary reporter (see --replay) to the selected reporters - the
+    // messages are read one at a time so the memory usage doesn't depend on the size of the stream.
+    // The replay stops at the first malformed message (the run fails then).
+    bool replayBinaryStream(ContextState* p) {
+        std::ifstream in(p->replay.c_str(), std::ios::binary);
+
+        char magic[sizeof(binaryStreamMagic) - 1];
+        if(!in.read(magic, sizeof(magic)) ||
+           std::memcmp(magic, binaryStreamMagic, sizeof(magic)) != 0)
+            return false;
+
+        BinaryReader reader(true);
+        std::string  msg;
+        unsigned     size;
+        bool         ended   = false;
+        bool         corrupt = false;
+        long long    offset  = sizeof(magic); // of the current message
+        while(!ended && in.read(reinterpret_cast<char*>(&size), sizeof(size))) {
+            // a message has at least a type and the number of contexts - and a size of more than a
+            // GiB is garbage rather than the truth
+            if(size < 1 + sizeof(unsigned) || size > (1u << 30)) {
+                corrupt = true;
+                break;
+            }
+            msg.resize(size);
+            if(!in.read(&msg[0], size))
+                break; // the writer died in the middle of a message
+
+            RecordedEvent     e;
+            binaryEvent::Enum type;
+            if(!reader.decode(msg.data(), size, e, type)) {
+                corrupt = true;
+                break;
+            }
+            ended = type == binaryEvent::TestRunEnd;
+            if(!ended)
+                replay(p, e);
+            offset += sizeof(size) + size;
+        }
+
+        if(corrupt) {
+            // after whatever the reporters have written so far
+            p->cout->flush();
+            std::fprintf(stderr,
+                         "[doctest] \"%s\" is corrupted - the replay stopped at the message at "
+                         "byte %lld\n",
+                         p->replay.c_str(), offset);
+        }
+
+        // also when the stream is truncated so the summary reflects what made it in
+        if(!reader.runStarted)
+            DOCTEST_ITERATE_THROUGH_REPORTERS(test_run_start, DOCTEST_EMPTY);
+        static_cast<TestRunStats&>(*p) = reader.runStats;
+        DOCTEST_ITERATE_THROUGH_REPORTERS(test_run_end, *p);
+        if(corrupt)
+            p->numTestCasesFailed = std::max(p->numTestCasesFailed, 1u);
+        return true;
+    }
+
+    // the implementation of parseOption()
+    bool parseOptionImpl(int argc, const char* const* argv, const char* pattern, String* value) {
+        // going from the end to the beginning and stopping on the first occurrence from the end
+        for(int i = argc; i > 0; --i) {
+            auto index = i - 1;
+            auto temp = std::strstr(argv[index], pattern);
+            if(temp && (value || strlen(temp) == strlen(pattern))) { //!OCLINT prefer early exits and continue
+                // eliminate matches in which the chars before the option are not '-'
+                bool noBadCharsFound = true;
+                auto curr            = argv[index];
+                while(curr != temp) {
+                    if(*curr++ != '-') {
+                        noBadCharsFound = false;
+                        break;
+                    }
+                }
+                if(noBadCharsFound && argv[index][0] == '-') {
+                    if(value) {
                         // parsing the value of an option
                         temp += strlen(pattern);
                         const unsigned len = strlen(temp);
@@ -3603,6 +6443,18 @@ void Context::parseArgs(int argc, const char* const* argv, bool withDefaults) {
 
     DOCTEST_PARSE_INT_OPTION("abort-after", "aa", abort_after, 0);
     DOCTEST_PARSE_INT_OPTION("subcase-filter-levels", "scfl", subcase_filter_levels, INT_MAX);
+    DOCTEST_PARSE_INT_OPTION("parallel", "par", parallel, 1);
+    DOCTEST_PARSE_INT_OPTION("benchmark-samples", "bms", benchmark_samples, 100);
+    DOCTEST_PARSE_INT_OPTION("benchmark-resamples", "bmr", benchmark_resamples, 100000);
+    DOCTEST_PARSE_INT_OPTION("benchmark-warmup", "bmw", benchmark_warmup, 100);
+    DOCTEST_PARSE_STR_OPTION("debugger-check", "dc", debugger_check, "once");
+    DOCTEST_PARSE_STR_OPTION("replay", "rp", replay, "");
+    DOCTEST_PARSE_STR_OPTION("durations-file", "df", durations_file, "");
+    DOCTEST_PARSE_INT_OPTION("slowest", "sl", slowest, 0);
+    DOCTEST_PARSE_INT_OPTION("shard-count", "shc", shard_count, 1);
+    DOCTEST_PARSE_INT_OPTION("shard-index", "shi", shard_index, 0);
+    DOCTEST_PARSE_INT_OPTION("test-timeout", "tt", test_timeout, 0);
+    DOCTEST_PARSE_INT_OPTION("out-buffer", "obf", out_buffer, 1024);
 
     DOCTEST_PARSE_AS_BOOL_OR_FLAG("success", "s", success, false);
     DOCTEST_PARSE_AS_BOOL_OR_FLAG("case-sensitive", "cs", case_sensitive, false);
@@ -3626,6 +6478,11 @@ void Context::parseArgs(int argc, const char* const* argv, bool withDefaults) {
     DOCTEST_PARSE_AS_BOOL_OR_FLAG("no-debug-output", "ndo", no_debug_output, false);
     DOCTEST_PARSE_AS_BOOL_OR_FLAG("no-skipped-summary", "nss", no_skipped_summary, false);
     DOCTEST_PARSE_AS_BOOL_OR_FLAG("no-time-in-output", "ntio", no_time_in_output, false);
+    DOCTEST_PARSE_AS_BOOL_OR_FLAG("isolate", "iso", isolate, false);
+    DOCTEST_PARSE_AS_BOOL_OR_FLAG("resource-summary", "res", resource_summary, false);
+    DOCTEST_PARSE_AS_BOOL_OR_FLAG("perf-counters", "pc", perf_counters, false);
+    DOCTEST_PARSE_AS_BOOL_OR_FLAG("async-reporters", "ar", async_reporters, false);
+    DOCTEST_PARSE_AS_BOOL_OR_FLAG("thread-logs", "tl", thread_logs, false);
     // clang-format on
 
     if(withDefaults) {
@@ -3727,66 +6584,1331 @@ public:
             : std::ostream(&discardBuf) {}
 } discardOut;
 
-// the main function that does all the filtering and test running
-int Context::run() {
+namespace {
     using namespace detail;
 
-    // save the old context state in case such was setup - for using asserts out of a testing context
-    auto old_cs = g_cs;
-    // this is the current contest
-    g_cs               = p;
-    is_running_in_test = true;
+    // executes the body of a test case once - following the path of subcases in nextSubcaseStack
+    void executeTestCaseBody(ContextState* p, const TestCase& tc) {
+        // reset some of the fields for subcases (except for the set of fully passed ones)
+        p->reachedLeaf = false;
+        // May not be empty if previous subcase exited via exception.
+        p->subcaseStack.clear();
+        p->currentSubcaseDepth = 0;
 
-    g_no_colors = p->no_colors;
-    p->resetRunData();
+        p->shouldLogCurrentException = true;
 
-    std::fstream fstr;
-    if(p->cout == nullptr) {
-        if(p->quiet) {
-            p->cout = &discardOut;
-        } else if(p->out.size()) {
-            // to a file if specified
-            fstr.open(p->out.c_str(), std::fstream::out);
-            p->cout = &fstr;
-        } else {
-#ifndef DOCTEST_CONFIG_NO_INCLUDE_IOSTREAM
-            // stdout by default
-            p->cout = &std::cout;
-#else // DOCTEST_CONFIG_NO_INCLUDE_IOSTREAM
-            return EXIT_FAILURE;
-#endif // DOCTEST_CONFIG_NO_INCLUDE_IOSTREAM
+        // reset stuff for logging with INFO()
+        p->stringifiedContexts.clear();
+
+#ifndef DOCTEST_CONFIG_NO_EXCEPTIONS
+        try {
+#endif // DOCTEST_CONFIG_NO_EXCEPTIONS
+            if(g_worker_cs) {
+                // signal handlers are process-wide so they can't be scoped to a worker
+                tc.m_test();
+            } else {
+// MSVC 2015 diagnoses fatalConditionHandler as unused (because reset() is a static method)
+DOCTEST_MSVC_SUPPRESS_WARNING_WITH_PUSH(4101) // unreferenced local variable
+                FatalConditionHandler fatalConditionHandler; // Handle signals
+                // execute the test
+                tc.m_test();
+                fatalConditionHandler.reset();
+DOCTEST_MSVC_SUPPRESS_WARNING_POP
+            }
+#ifndef DOCTEST_CONFIG_NO_EXCEPTIONS
+        } catch(const TestFailureException&) {
+            p->failure_flags |= TestCaseFailureReason::AssertFailure;
+        } catch(...) {
+            DOCTEST_ITERATE_THROUGH_REPORTERS(test_case_exception,
+                                              {translateActiveException(), false});
+            p->failure_flags |= TestCaseFailureReason::Exception;
         }
+#endif // DOCTEST_CONFIG_NO_EXCEPTIONS
     }
 
-    FatalConditionHandler::allocateAltStackMem();
+    // reenters a test case until all of its subcases have been traversed
+    void traverseSubcases(ContextState* p, const TestCase& tc) {
+        bool run_test = true;
 
-    auto cleanup_and_return = [&]() {
-        FatalConditionHandler::freeAltStackMem();
+        do {
+            executeTestCaseBody(p, tc);
 
-        if(fstr.is_open())
-            fstr.close();
+            // exit this loop if enough assertions have failed - even if there are more subcases
+            if(p->abort_after > 0 &&
+               p->numAssertsFailed + p->assertCounters.numAssertsFailed() >= p->abort_after) {
+                run_test = false;
+                p->failure_flags |= TestCaseFailureReason::TooManyFailedAsserts;
+            }
 
-        // restore context
-        g_cs               = old_cs;
-        is_running_in_test = false;
+            if(!p->nextSubcaseStack.empty() && run_test)
+                DOCTEST_ITERATE_THROUGH_REPORTERS(test_case_reenter, tc);
+            if(p->nextSubcaseStack.empty())
+                run_test = false;
+        } while(run_test);
+    }
 
-        // we have to free the reporters which were allocated when the run started
-        for(auto& curr : p->reporters_currently_used)
-            delete curr;
-        p->reporters_currently_used.clear();
+#ifndef DOCTEST_CONFIG_NO_MULTITHREADING
+    void traverseSubcasesInParallel(ContextState* p, const TestCase& tc);
+#endif // DOCTEST_CONFIG_NO_MULTITHREADING
 
-        if(p->numTestCasesFailed && !p->no_exitcode)
-            return EXIT_FAILURE;
-        return EXIT_SUCCESS;
-    };
+    // executes a test case (reentering it until all of its subcases have been traversed) and
+    // reports it - the run data has to be the current state of the calling thread
+    void runTestCase(ContextState* p, const TestCase& tc) {
+        p->currentTest = &tc;
 
-    // setup default reporter if none is given through the command line
-    if(p->filters[8].empty())
-        p->filters[8].push_back("console");
+        p->failure_flags = TestCaseFailureReason::None;
+        p->seconds       = 0;
 
-    // check to see if any of the registered reporters has been selected
-    for(auto& curr : getReporters()) {
-        if(matchesAny(curr.first.second.c_str(), p->filters[8], false, p->case_sensitive))
+        p->assertCounters.reset();
+
+        p->subcaseTree.clear();
+        p->nextSubcaseStack.clear();
+
+        // the peak of the heap usage is measured from what the thread has allocated until now
+        g_allocations.peak    = g_allocations.live;
+        p->allocations        = &g_allocations;
+        p->allocationsAtStart = g_allocations;
+
+        DOCTEST_ITERATE_THROUGH_REPORTERS(test_case_start, tc);
+
+        p->resourcesSampled = p->resource_summary && sampleResources(p->resourcesAtStart);
+
+        p->subcasePerfStack.clear();
+        if(p->perf_counters)
+            g_perfCounters.sample(p->perfAtStart);
+
+        p->timer.start();
+
+#ifndef DOCTEST_CONFIG_NO_MULTITHREADING
+        // the watchdog can stop only the thread which owns the signal handlers - not the workers
+        const bool watched = p->watchdog && !g_worker_cs && p->timeLimit(tc) > 0;
+        if(watched)
+            p->watchdog->arm(p->timeLimit(tc));
+
+        if(tc.m_parallel_subcases)
+            traverseSubcasesInParallel(p, tc);
+        else
+#endif // DOCTEST_CONFIG_NO_MULTITHREADING
+            traverseSubcases(p, tc);
+
+        deliverThreadLogs(p);
+
+        p->releaseTestCache();
+
+#ifndef DOCTEST_CONFIG_NO_MULTITHREADING
+        if(watched)
+            p->watchdog->disarm();
+#endif // DOCTEST_CONFIG_NO_MULTITHREADING
+        if(p->perf_counters)
+            reportPerfCounters(PerfCounterScope::TestCase, tc.m_name, tc.m_file.c_str(), tc.m_line,
+                               perfCountersSince(p->perfAtStart));
+
+        p->finalizeTestCaseData();
+
+        DOCTEST_ITERATE_THROUGH_REPORTERS(test_case_end, *p);
+
+        p->currentTest = nullptr;
+    }
+
+#ifndef DOCTEST_CONFIG_NO_MULTITHREADING
+    // records the reporter events of the test cases so they can be replayed later - see replay()
+    struct EventRecorder : public IReporter
+    {
+        // the options of the test code and those of the state the events get replayed to - the
+        // events carry the former while they differ (if they are set - see OutputOptions)
+        const ContextOptions* recordedOptions = nullptr;
+        OutputOptions         replayedOptions;
+
+        virtual void add(RecordedEvent&& e) = 0;
+
+        void record(std::function<void(IReporter*)> report, bool withContexts = true,
+                    bool withStringified = false) {
+            RecordedEvent e;
+            e.report = std::move(report);
+            if(recordedOptions && !replayedOptions.sameAs(*recordedOptions)) {
+                e.withOptions = true;
+                e.options     = OutputOptions(*recordedOptions);
+            }
+            if(withContexts) {
+                for(int i = 0; i < get_num_active_contexts(); ++i) {
+                    std::ostringstream s;
+                    get_active_contexts()[i]->stringify(&s);
+                    e.contexts.push_back(s.str().c_str());
+                }
+            }
+            if(withStringified)
+                for(int i = 0; i < get_num_stringified_contexts(); ++i)
+                    e.stringified.push_back(get_stringified_contexts()[i]);
+            add(std::move(e));
+        }
+
+        void report_query(const QueryData&) override {}
+        void test_run_start() override {}
+        void test_run_end(const TestRunStats&) override {}
+
+        void test_case_start(const TestCaseData& in) override {
+            const TestCaseData* tc = &in;
+            record([tc](IReporter* r) { r->test_case_start(*tc); }, false);
+        }
+        void test_case_reenter(const TestCaseData& in) override {
+            const TestCaseData* tc = &in;
+            record([tc](IReporter* r) { r->test_case_reenter(*tc); }, false);
+        }
+        void test_case_end(const CurrentTestCaseStats& in) override {
+            CurrentTestCaseStats st = in;
+            record([st](IReporter* r) { r->test_case_end(st); }, false);
+        }
+        void test_case_exception(const TestCaseException& in) override {
+            TestCaseException e = in;
+            record([e](IReporter* r) { r->test_case_exception(e); }, true, true);
+        }
+        void subcase_start(const SubcaseSignature& in) override {
+            SubcaseSignature sig = in;
+            record([sig](IReporter* r) { r->subcase_start(sig); }, false);
+        }
+        void subcase_end() override {
+            record([](IReporter* r) { r->subcase_end(); }, false);
+        }
+        void log_assert(const AssertData& in) override {
+            AssertData ad = in;
+            record([ad](IReporter* r) { r->log_assert(ad); }, withAssertContexts(in));
+        }
+        void log_message(const MessageData& in) override {
+            MessageData mb = in;
+            record([mb](IReporter* r) { r->log_message(mb); });
+        }
+        void benchmark_end(const BenchmarkStats& in) override {
+            BenchmarkStats st = in;
+            record([st](IReporter* r) { r->benchmark_end(st); }, false);
+        }
+        void perf_counters(const PerfCounterStats& in) override {
+            PerfCounterStats st = in;
+            record([st](IReporter* r) { r->perf_counters(st); }, false);
+        }
+        void test_case_skipped(const TestCaseData&) override {}
+    };
+
+    // the log of a thread started by a test case (see --thread-logs) - only the thread itself
+    // appends to it so the mutex is contended just while the events are being delivered
+    struct ThreadLog : public EventRecorder
+    {
+        DOCTEST_DECLARE_MUTEX(mutex)
+        std::vector<RecordedEvent> events;
+        ContextState*              owner    = nullptr; // gets the events - picked by the first one
+        bool                       finished = false;   // the thread has ended
+
+        // the events go to the state of the test code which has started the thread - if that
+        // can't be told the test code gets executed again and the events are dropped meanwhile
+        void add(RecordedEvent&& e) override {
+            DOCTEST_LOCK_MUTEX(mutex)
+            if(!owner)
+                owner = currentState();
+            if(owner == &getExecutingStates().stray)
+                owner = nullptr;
+            else
+                events.push_back(std::move(e));
+        }
+    };
+
+    struct ThreadLogs
+    {
+        DOCTEST_DECLARE_MUTEX(mutex)
+        std::vector<ThreadLog*> logs; // in the order of the first events of the threads
+    };
+
+    ThreadLogs& getThreadLogs() {
+        static ThreadLogs data;
+        return data;
+    }
+
+    // marks the log of the thread as finished when the thread ends so it can be dropped
+    struct ThreadLogHandle
+    {
+        ThreadLog* log = nullptr;
+
+        ~ThreadLogHandle() {
+            if(log) {
+                DOCTEST_LOCK_MUTEX(log->mutex)
+                log->finished = true;
+            }
+        }
+    };
+
+    DOCTEST_THREAD_LOCAL ThreadLogHandle g_thread_log;
+
+    ThreadLog* getOwnThreadLog() {
+        if(g_doctest_thread || g_worker_cs || !g_cs->thread_logs)
+            return nullptr;
+        if(!g_thread_log.log) {
+            ThreadLogs& data = getThreadLogs();
+            DOCTEST_LOCK_MUTEX(data.mutex)
+            g_thread_log.log = new ThreadLog();
+            data.logs.push_back(g_thread_log.log);
+        }
+        return g_thread_log.log;
+    }
+
+    // a bounded queue for many producers and a single consumer (after the bounded MPMC queue of
+    // Dmitry Vyukov) - a producer claims a cell by advancing the enqueue position with a CAS and
+    // publishes it through the sequence number of the cell so no locks are taken
+    template <typename T>
+    class BoundedQueue
+    {
+        struct Cell
+        {
+            std::atomic<size_t> sequence;
+            T                   value;
+        };
+
+        std::vector<Cell>   m_cells;
+        const size_t        m_mask;
+        std::atomic<size_t> m_enqueuePos{0};
+        size_t              m_dequeuePos = 0; // only the consumer touches it
+
+    public:
+        // the capacity should be a power of 2
+        explicit BoundedQueue(size_t capacity)
+                : m_cells(capacity)
+                , m_mask(capacity - 1) {
+            for(size_t i = 0; i < capacity; ++i)
+                m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        // returns false if the queue is full
+        bool tryPush(T& in) {
+            size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+            for(;;) {
+                Cell&        cell = m_cells[pos & m_mask];
+                const size_t seq  = cell.sequence.load(std::memory_order_acquire);
+                if(seq == pos) {
+                    if(m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        cell.value = std::move(in);
+                        cell.sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if(seq < pos) {
+                    return false; // the cell hasn't been consumed since the last round
+                } else {
+                    pos = m_enqueuePos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // returns false if the queue is empty
+        bool tryPop(T& out) {
+            Cell& cell = m_cells[m_dequeuePos & m_mask];
+            if(cell.sequence.load(std::memory_order_acquire) != m_dequeuePos + 1)
+                return false;
+            out = std::move(cell.value);
+            cell.value = T();
+            cell.sequence.store(m_dequeuePos + m_mask + 1, std::memory_order_release);
+            ++m_dequeuePos;
+            return true;
+        }
+    };
+
+    // registered as the only reporter of the run with --async-reporters - the events are recorded
+    // into a bounded queue and delivered to the real reporters on a thread of their own so the
+    // tests don't wait for the formatting and writing of the output (only for a free cell)
+    class AsyncReporter : public EventRecorder
+    {
+        ContextState                m_state; // of the reporter thread - with the real reporters
+        BoundedQueue<RecordedEvent> m_queue;
+        std::atomic<size_t>         m_pushed{0};
+        std::atomic<size_t>         m_delivered{0};
+        std::atomic<bool>           m_stop{false};
+        std::thread                 m_thread;
+
+        void deliver() {
+            g_worker_cs = &m_state;
+            g_no_colors = m_state.no_colors;
+
+            RecordedEvent e;
+            unsigned      idle = 0;
+            for(;;) {
+                if(m_queue.tryPop(e)) {
+                    replay(&m_state, e);
+                    e = RecordedEvent();
+                    m_delivered.fetch_add(1, std::memory_order_release);
+                    idle = 0;
+                } else if(m_stop.load(std::memory_order_acquire)) {
+                    break;
+                } else if(++idle < 64) {
+                    std::this_thread::yield();
+                } else {
+                    std::this_thread::sleep_for(std::chrono::microseconds(idle < 1024 ? 50 : 1000));
+                }
+            }
+        }
+
+        // waits until the reporters have received everything queued until now - there is no one
+        // to wait for if a reporter itself has crashed on the thread delivering the events
+        void drain() {
+            if(std::this_thread::get_id() == m_thread.get_id())
+                return;
+            while(m_delivered.load(std::memory_order_acquire) !=
+                  m_pushed.load(std::memory_order_acquire))
+                std::this_thread::yield();
+        }
+
+    public:
+        AsyncReporter(const ContextState* p, size_t capacity)
+                : m_queue(capacity) {
+            static_cast<ContextOptions&>(m_state) = *p;
+            m_state.reporters_currently_used     = p->reporters_currently_used;
+            m_state.report_successful_asserts     = p->report_successful_asserts;
+            m_thread = std::thread([this]() { deliver(); });
+        }
+
+        ~AsyncReporter() override {
+            drain();
+            m_stop.store(true, std::memory_order_release);
+            m_thread.join();
+            for(auto& curr : m_state.reporters_currently_used)
+                delete curr;
+        }
+
+        // waits (yielding) while the queue is full so the reporters can keep up
+        void add(RecordedEvent&& e) override {
+            m_pushed.fetch_add(1, std::memory_order_relaxed);
+            while(!m_queue.tryPush(e))
+                std::this_thread::yield();
+        }
+
+        bool wants_successful_asserts() const override { return m_state.report_successful_asserts; }
+
+        void test_run_start() override {
+            record([](IReporter* r) { r->test_run_start(); }, false);
+        }
+
+        // also called when a test case crashes - before the process ends
+        void test_run_end(const TestRunStats& in) override {
+            const TestRunStats st = in;
+            record([st](IReporter* r) { r->test_run_end(st); }, false);
+            drain();
+        }
+
+        void test_case_skipped(const TestCaseData& in) override {
+            const TestCaseData* tc = &in;
+            record([tc](IReporter* r) { r->test_case_skipped(*tc); }, false);
+        }
+    };
+
+    // runs the test cases on a pool of workers (see --parallel) - every worker records the
+    // reporter events of the test cases it executes and the main thread replays them in the
+    // original order so the output of the real reporters is the same as for a serial run
+    struct ParallelTestRunner
+    {
+        struct Slot
+        {
+            const TestCase*      tc;
+            bool                 skipped;
+            bool                 done;
+            std::vector<RecordedEvent> events;
+            CurrentTestCaseStats stats;
+
+            Slot(const TestCase* in, bool skip)
+                    : tc(in), skipped(skip), done(false) {}
+        };
+
+        // registered as the only reporter of a worker thread - appends to the slot being executed
+        // (threads started by the test case might report through it too)
+        struct Recorder : public EventRecorder
+        {
+            DOCTEST_DECLARE_MUTEX(mutex)
+            std::vector<RecordedEvent>* events = nullptr;
+
+            void add(RecordedEvent&& e) override {
+                DOCTEST_LOCK_MUTEX(mutex)
+                events->push_back(std::move(e));
+            }
+        };
+
+#ifdef DOCTEST_CONFIG_POSIX_FORK
+        // registered as the only reporter of a forked worker (see --isolate) - sends the events to
+        // the parent process through a pipe (the parent knows which test case is being executed)
+        struct EventWriter : public BinaryWriter
+        {
+            int fd;
+
+            EventWriter(int out, const ContextOptions& co)
+                    : BinaryWriter(false, co)
+                    , fd(out) {}
+
+            // events are buffered until the end of a test case (which is reported on a crash too)
+            void flush() override {
+                for(size_t written = 0; written < buf.size();) {
+                    const auto res = ::write(fd, buf.data() + written, buf.size() - written);
+                    if(res < 0 && errno == EINTR)
+                        continue;
+                    if(res <= 0)
+                        _exit(EXIT_FAILURE); // the parent is gone
+                    written += size_t(res);
+                }
+                buf.clear();
+            }
+        };
+
+        struct Worker
+        {
+            pid_t       pid  = -1;
+            int         cmd  = -1; // test case indices are written here
+            int         res  = -1; // events are read from here
+            Slot*       slot = nullptr;
+            size_t      index = 0; // of the slot in the runnable test cases
+            bool        ended = false; // it has reported the end of its run - it is about to exit
+            Timer        timer;
+            BinaryReader reader{false};
+            std::string  buf;
+        };
+
+        std::vector<Worker> processes;
+        std::vector<size_t> requeued; // dispatched to a worker which had already died
+#endif // DOCTEST_CONFIG_POSIX_FORK
+
+        ContextState*       p;
+        std::vector<Slot>   slots;
+        std::vector<size_t> runnable;
+
+        std::atomic<size_t> next{0};
+        std::atomic<bool>   stop{false};
+        DOCTEST_DECLARE_MUTEX(mutex)
+        std::condition_variable cv;
+
+        // the test cases which are executed again on their own (see spawnedThreadState())
+        size_t executing = 0;     // by the workers
+        size_t waiting   = 0;     // for the others to finish so they can be executed again
+        bool   exclusive = false; // one is being executed again
+
+        std::vector<ContextState> states;
+        std::vector<std::thread>  threads;
+
+        explicit ParallelTestRunner(ContextState* in)
+                : p(in) {}
+
+        void add(const TestCase& tc, bool skipped) { slots.emplace_back(&tc, skipped); }
+
+        void work(ContextState& ws) {
+            Recorder recorder;
+            recorder.recordedOptions = &ws;
+            // those of p as they were copied - the main thread changes them while replaying
+            recorder.replayedOptions = OutputOptions(ws);
+            ws.reporters_currently_used.push_back(&recorder);
+
+            g_worker_cs = &ws;
+            for(size_t i = next++; i < runnable.size() && !stop; i = next++) {
+                Slot& slot = slots[runnable[i]];
+                {
+                    DOCTEST_LOCK_MUTEX(recorder.mutex)
+                    recorder.events = &slot.events;
+                }
+
+                execute(ws, recorder, slot);
+
+                {
+                    DOCTEST_LOCK_MUTEX(mutex)
+                    slot.stats = ws;
+                    slot.done  = true;
+                }
+                cv.notify_all();
+            }
+            g_worker_cs = nullptr;
+        }
+
+        // when the asserts of a thread started by the test case couldn't be told apart from those
+        // of a thread started by another one it gets executed again once the others have finished
+        // (and no new ones start until it has finished) so every assert is reported where it belongs
+        void execute(ContextState& ws, Recorder& recorder, Slot& slot) {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this]() { return !exclusive && waiting == 0; });
+            ++executing;
+            lock.unlock();
+
+            {
+                ExecutingScope scope(&ws, nullptr);
+                runTestCase(&ws, *slot.tc);
+            }
+
+            lock.lock();
+            --executing;
+            if(ws.strayAsserts) {
+                ++waiting;
+                cv.notify_all();
+                cv.wait(lock, [this]() { return !exclusive && executing == 0; });
+                --waiting;
+                exclusive = true;
+                lock.unlock();
+
+                {
+                    DOCTEST_LOCK_MUTEX(recorder.mutex)
+                    slot.events.clear();
+                }
+                {
+                    ExecutingScope scope(&ws, nullptr);
+                    runTestCase(&ws, *slot.tc);
+                }
+
+                lock.lock();
+                exclusive = false;
+            }
+            lock.unlock();
+            cv.notify_all();
+        }
+
+        // the options are copied before any of the workers has started
+        static void initWorkerState(ContextState& ws, const ContextState* p) {
+            static_cast<ContextOptions&>(ws) = *p;
+            ws.filters        = p->filters;
+            ws.filterMatchers = p->filterMatchers;
+            ws.ah             = p->ah;
+
+            ws.report_successful_asserts = p->report_successful_asserts;
+            ws.resetRunData();
+        }
+
+#ifdef DOCTEST_CONFIG_POSIX_FORK
+        // the body of a forked worker - executes the test cases the parent asks for until the
+        // command pipe gets closed (or a test case crashes the process)
+        DOCTEST_NORETURN void serve(int in, int out) {
+            EventWriter writer(out, *p);
+            p->reporters_currently_used.assign(1, &writer);
+            // the events of a test case stopped by the watchdog can't be flushed anymore
+            if(p->watchdog) {
+                p->watchdog->forkedWorker();
+                writer.maxBuffered = 0;
+            }
+
+            unsigned index;
+            for(;;) {
+                const auto res = ::read(in, &index, sizeof(index));
+                if(res < 0 && errno == EINTR)
+                    continue;
+                if(res != sizeof(index))
+                    break;
+
+                runTestCase(p, *slots[index].tc);
+
+                // whatever the test case printed on its own
+                std::fflush(nullptr);
+#ifndef DOCTEST_CONFIG_NO_INCLUDE_IOSTREAM
+                std::cout.flush();
+                std::cerr.flush();
+#endif // DOCTEST_CONFIG_NO_INCLUDE_IOSTREAM
+            }
+            _exit(EXIT_SUCCESS);
+        }
+
+        bool spawn(Worker& w) {
+            int cmd[2], res[2];
+            if(::pipe(cmd) != 0)
+                return false;
+            if(::pipe(res) != 0) {
+                ::close(cmd[0]);
+                ::close(cmd[1]);
+                return false;
+            }
+
+            // don't let the children inherit anything which is still buffered
+            p->cout->flush();
+            std::fflush(nullptr);
+
+            const pid_t pid = ::fork();
+            if(pid == 0) {
+                ::close(cmd[1]);
+                ::close(res[0]);
+                // the pipes of the other workers shouldn't be kept open by this one
+                for(auto& other : processes) {
+                    if(other.cmd != -1)
+                        ::close(other.cmd);
+                    if(other.res != -1)
+                        ::close(other.res);
+                }
+                serve(cmd[0], res[1]);
+            }
+
+            ::close(cmd[0]);
+            ::close(res[1]);
+            if(pid < 0) {
+                ::close(cmd[1]);
+                ::close(res[0]);
+                return false;
+            }
+
+            w     = Worker();
+            w.pid = pid;
+            w.cmd = cmd[1];
+            w.res = res[0];
+            return true;
+        }
+
+        void dispatch(Worker& w) {
+            size_t i = runnable.size();
+            if(!requeued.empty()) {
+                i = requeued.back();
+                requeued.pop_back();
+            } else if(!stop && next < runnable.size()) {
+                i = next++;
+            }
+
+            if(i == runnable.size()) {
+                // nothing left to do - the worker exits once its command pipe is closed
+                ::close(w.cmd);
+                w.cmd = -1;
+                return;
+            }
+
+            const auto index = unsigned(runnable[i]);
+            if(::write(w.cmd, &index, sizeof(index)) != sizeof(index)) {
+                requeued.push_back(i);
+                return;
+            }
+            w.slot                    = &slots[runnable[i]];
+            w.index                   = i;
+            w.reader.tc               = w.slot->tc;
+            w.reader.numAssertsFailed = 0;
+            w.timer.start();
+        }
+
+        // reports the test case which was running when a worker died as a crash
+        void reportLostTestCase(Worker& w, int status) {
+            Slot& slot = *w.slot;
+            const TestCaseData* tc = slot.tc;
+
+            // the events of the test case are flushed only once it ends so nothing has been received
+            if(slot.events.empty()) {
+                RecordedEvent e;
+                e.report = [tc](IReporter* r) { r->test_case_start(*tc); };
+                slot.events.push_back(std::move(e));
+            }
+
+            // the watchdog of the worker exits without reporting a test case which timed out
+            const double limit = p->timeLimit(*slot.tc);
+            String       reason;
+            if(p->test_timeout > 0 && w.timer.getElapsedSeconds() >= limit)
+                reason = String("exceeded the time limit of ") + toString(limit) + " seconds";
+            else if(WIFSIGNALED(status))
+                reason = String("the worker process was terminated by signal ") +
+                         toString(WTERMSIG(status)) + " (" + ::strsignal(WTERMSIG(status)) + ")";
+            else
+                reason = String("the worker process exited with code ") +
+                         toString(WEXITSTATUS(status)) + " while running the test case";
+
+            RecordedEvent crash;
+            crash.report = [reason](IReporter* r) { r->test_case_exception({reason, true}); };
+            slot.events.push_back(std::move(crash));
+
+            // the same evaluation as for a crash which happens while running serially
+            ContextState cs;
+            cs.resetRunData();
+            cs.currentTest   = slot.tc;
+            cs.test_timeout  = p->test_timeout;
+            cs.failure_flags = TestCaseFailureReason::Crash;
+            cs.timer         = w.timer;
+            cs.assertCounters.reset(0, w.reader.numAssertsFailed);
+            cs.finalizeTestCaseData();
+
+            CurrentTestCaseStats st = cs;
+            RecordedEvent end;
+            end.report = [st](IReporter* r) { r->test_case_end(st); };
+            slot.events.push_back(std::move(end));
+
+            slot.stats = st;
+            slot.done  = true;
+        }
+
+        void reap(Worker& w) {
+            if(w.cmd != -1)
+                ::close(w.cmd);
+            ::close(w.res);
+            w.cmd = w.res = -1;
+
+            int status = 0;
+            while(::waitpid(w.pid, &status, 0) < 0 && errno == EINTR) {}
+            w.pid = -1;
+
+            if(w.slot && !w.slot->done) {
+                // the test case was sent after the previous one had crashed (or timed out)
+                if(w.ended && w.slot->events.empty())
+                    requeued.push_back(w.index);
+                else
+                    reportLostTestCase(w, status);
+            }
+            w.slot = nullptr;
+
+            // replace the worker if there is still work to do
+            if(!stop && (next < runnable.size() || !requeued.empty()) && spawn(w))
+                dispatch(w);
+        }
+
+        // waits for events from the workers and processes them
+        void pump() {
+            std::vector<pollfd> fds;
+            std::vector<Worker*> owners;
+            for(auto& w : processes) {
+                if(w.pid != -1) {
+                    fds.push_back({w.res, POLLIN, 0});
+                    owners.push_back(&w);
+                }
+            }
+
+            // the watchdog of a worker stops a test case which exceeds its time limit and exits (it
+            // waits up to a second for the stack) - a worker which hasn't done that is killed
+            int wait = -1;
+            if(p->test_timeout > 0) {
+                for(auto w : owners) {
+                    if(!w->slot)
+                        continue;
+                    const double left =
+                            p->timeLimit(*w->slot->tc) + 3 - w->timer.getElapsedSeconds();
+                    if(left <= 0)
+                        ::kill(w->pid, SIGKILL);
+                    const int ms = left > 0 ? int(left * 1000) + 1 : 10;
+                    wait         = wait < 0 ? ms : std::min(wait, ms);
+                }
+            }
+
+            if(fds.empty() || ::poll(fds.data(), fds.size(), wait) < 0)
+                return;
+
+            for(size_t i = 0; i < fds.size(); ++i) {
+                if(fds[i].revents == 0)
+                    continue;
+
+                Worker& w = *owners[i];
+                char    chunk[65536];
+                const auto res = ::read(w.res, chunk, sizeof(chunk));
+                if(res < 0 && errno == EINTR)
+                    continue;
+                if(res <= 0) {
+                    reap(w);
+                    continue;
+                }
+                w.buf.append(chunk, size_t(res));
+
+                // process all the complete messages
+                size_t pos = 0;
+                unsigned size;
+                while(w.buf.size() - pos >= sizeof(size)) {
+                    std::memcpy(&size, w.buf.data() + pos, sizeof(size));
+                    if(w.buf.size() - pos - sizeof(size) < size)
+                        break;
+
+                    Slot*             slot = w.slot;
+                    RecordedEvent     e;
+                    binaryEvent::Enum type;
+                    if(!w.reader.decode(w.buf.data() + pos + sizeof(size), size, e, type)) {
+                        // the worker can't be trusted anymore - as if it had crashed
+                        ::kill(w.pid, SIGKILL);
+                        w.buf.clear();
+                        pos = 0;
+                        reap(w);
+                        break;
+                    }
+                    pos += sizeof(size) + size;
+
+                    // a worker ends its run only after a crash or a timeout - right before it exits
+                    if(type == binaryEvent::TestRunEnd) {
+                        w.ended = true;
+                        continue;
+                    }
+
+                    if(type == binaryEvent::TestCaseEnd) {
+                        slot->stats = w.reader.testCaseStats;
+                        slot->done  = true;
+                    }
+                    slot->events.push_back(std::move(e));
+
+                    if(slot->done) {
+                        w.slot = nullptr;
+                        dispatch(w);
+                    }
+                }
+                w.buf.erase(0, pos);
+            }
+        }
+
+        void startProcesses() {
+            // --isolate on its own executes the test cases one by one in a single worker
+            processes.resize(std::min(size_t(std::max(p->parallel, 1)), runnable.size()));
+            for(auto& w : processes)
+                if(!spawn(w))
+                    w = Worker();
+            for(auto& w : processes)
+                if(w.pid != -1)
+                    dispatch(w);
+        }
+
+        void stopProcesses() {
+            for(auto& w : processes) {
+                if(w.pid == -1)
+                    continue;
+                // a worker might be in the middle of a test case after --abort-after kicked in
+                if(w.slot)
+                    ::kill(w.pid, SIGKILL);
+                w.slot = nullptr;
+                reap(w);
+            }
+        }
+#endif // DOCTEST_CONFIG_POSIX_FORK
+
+        void waitFor(Slot& slot) {
+#ifdef DOCTEST_CONFIG_POSIX_FORK
+            if(p->isolate) {
+                while(!slot.done) {
+                    const bool anyAlive = std::any_of(processes.begin(), processes.end(),
+                                                      [](const Worker& w) { return w.pid != -1; });
+                    if(anyAlive) {
+                        pump();
+                    } else {
+                        // no worker process could be started - fall back to the calling thread
+                        ContextState ws;
+                        initWorkerState(ws, p);
+                        work(ws);
+                    }
+                }
+                return;
+            }
+#endif // DOCTEST_CONFIG_POSIX_FORK
+
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&slot]() { return slot.done; });
+        }
+
+        void run() {
+            for(size_t i = 0; i < slots.size(); ++i)
+                if(!slots[i].skipped)
+                    runnable.push_back(i);
+
+#ifdef DOCTEST_CONFIG_POSIX_FORK
+            // writing to the pipe of a crashed worker shouldn't bring down the whole run
+            auto oldSigpipe = std::signal(SIGPIPE, SIG_IGN);
+            if(p->isolate)
+                startProcesses();
+            else
+#endif // DOCTEST_CONFIG_POSIX_FORK
+            {
+                states = std::vector<ContextState>(std::min(size_t(p->parallel), runnable.size()));
+                for(auto& ws : states)
+                    initWorkerState(ws, p);
+                for(auto& ws : states)
+                    threads.emplace_back([this, &ws]() { work(ws); });
+            }
+
+            for(auto& slot : slots) {
+                if(slot.skipped) {
+                    DOCTEST_ITERATE_THROUGH_REPORTERS(test_case_skipped, *slot.tc);
+                    continue;
+                }
+
+                // the test cases after an abort were counted as passing the filters but aren't run
+                if(stop) {
+                    p->numTestCasesPassingFilters--;
+                    continue;
+                }
+
+                waitFor(slot);
+
+                for(auto& e : slot.events)
+                    replay(p, e);
+                slot.events.clear();
+
+                static_cast<CurrentTestCaseStats&>(*p) = slot.stats;
+                if(p->durations_file.size())
+                    p->durationHistory.record(*slot.tc, slot.stats.seconds);
+                p->numAsserts += slot.stats.numAssertsCurrentTest;
+                p->numAssertsFailed += slot.stats.numAssertsFailedCurrentTest;
+                if(!slot.stats.testCaseSuccess)
+                    p->numTestCasesFailed++;
+
+                // stop executing tests if enough assertions have failed
+                if(p->abort_after > 0 && p->numAssertsFailed >= p->abort_after)
+                    stop = true;
+            }
+
+            for(auto& thread : threads)
+                thread.join();
+
+#ifdef DOCTEST_CONFIG_POSIX_FORK
+            stopProcesses();
+            std::signal(SIGPIPE, oldSigpipe);
+#endif // DOCTEST_CONFIG_POSIX_FORK
+        }
+    };
+
+    // traverses the subcases of a test case with parallel_subcases() on a pool of threads - every
+    // pass through the test case executes one leaf and the untraversed subcases it runs into below
+    // its forced path become new passes. A pass is keyed by the key of the pass which found it and
+    // the order in which they were found so sorting the keys gives the order of a serial traversal
+    // and the recorded events are replayed in that order. If the asserts of a thread started by a
+    // pass couldn't be told apart from those of another pass the subcases are traversed serially.
+    void traverseSubcasesInParallel(ContextState* p, const TestCase& tc) {
+        struct Pass
+        {
+            std::vector<unsigned>         key;
+            std::vector<SubcaseSignature> path;
+            std::vector<RecordedEvent>    events;
+            bool                          done          = false;
+            int                           failure_flags = 0;
+            int                           asserts       = 0;
+            int                           failed        = 0;
+        };
+
+        std::deque<Pass> passes(1);
+        size_t           next    = 0; // the first pass which hasn't been started
+        size_t           running = 0;
+        int              failed  = 0;
+        bool             stop    = false;
+        bool             stray   = false;
+        DOCTEST_DECLARE_MUTEX(mutex)
+        std::condition_variable cv;
+
+        auto work = [&](ContextState& ws) {
+            ParallelTestRunner::Recorder recorder;
+            recorder.recordedOptions = &ws;
+            recorder.replayedOptions = OutputOptions(ws);
+            ws.reporters_currently_used.assign(1, &recorder);
+            ws.currentTest = &tc;
+
+            ContextState* const prev = g_worker_cs;
+            g_worker_cs              = &ws;
+
+            std::unique_lock<std::mutex> lock(mutex);
+            for(;;) {
+                cv.wait(lock, [&]() { return stop || next < passes.size() || running == 0; });
+                if(stop || next == passes.size())
+                    break;
+                Pass& pass = passes[next++]; // the references of a deque stay valid when growing
+                ++running;
+                lock.unlock();
+
+                std::vector<std::vector<SubcaseSignature>> found;
+                ws.failure_flags = TestCaseFailureReason::None;
+                ws.assertCounters.reset();
+                ws.subcaseTree.clear();
+                ws.nextSubcaseStack.clear();
+                for(auto& sig : pass.path)
+                    ws.nextSubcaseStack.push_back(ws.subcaseTree.node(
+                            ws.nextSubcaseStack.empty() ? 0 : ws.nextSubcaseStack.back(), sig));
+                ws.discoveredSubcases = &found;
+                ws.forcedSubcaseDepth = pass.path.size();
+                {
+                    DOCTEST_LOCK_MUTEX(recorder.mutex)
+                    recorder.events = &pass.events;
+                }
+
+                {
+                    ExecutingScope scope(&ws, p);
+                    executeTestCaseBody(&ws, tc);
+                    deliverThreadLogs(&ws);
+                }
+
+                pass.failure_flags = ws.failure_flags;
+                pass.asserts       = ws.assertCounters.numAsserts();
+                pass.failed        = ws.assertCounters.numAssertsFailed();
+
+                lock.lock();
+                pass.done = true;
+                --running;
+                stray = stray || ws.strayAsserts;
+                // no new passes once enough assertions have failed
+                if(p->abort_after > 0 &&
+                   p->numAssertsFailed + (failed += pass.failed) >= p->abort_after)
+                    stop = true;
+                for(size_t i = 0; i < found.size() && !stop; ++i) {
+                    passes.emplace_back();
+                    passes.back().key = pass.key;
+                    passes.back().key.push_back(unsigned(i + 1));
+                    passes.back().path = std::move(found[i]);
+                }
+                cv.notify_all();
+            }
+            lock.unlock();
+
+            // every worker computes the values of test_cache() for the passes it has executed
+            ws.releaseTestCache();
+            g_worker_cs = prev;
+        };
+
+        const size_t numThreads =
+                p->parallel > 1 ? size_t(p->parallel) : size_t(std::thread::hardware_concurrency());
+        std::vector<ContextState> states(numThreads > 1 ? numThreads : 2);
+        std::vector<std::thread>  threads;
+        for(auto& ws : states) {
+            ParallelTestRunner::initWorkerState(ws, p);
+            threads.emplace_back([&work, &ws]() { work(ws); });
+        }
+        for(auto& thread : threads)
+            thread.join();
+
+        if(stray) {
+            traverseSubcases(p, tc);
+            return;
+        }
+
+        std::vector<const Pass*> order;
+        for(auto& pass : passes)
+            if(pass.done)
+                order.push_back(&pass);
+        std::sort(order.begin(), order.end(),
+                  [](const Pass* lhs, const Pass* rhs) { return lhs->key < rhs->key; });
+
+        // the same reporting and cut off by --abort-after as with a serial traversal
+        int asserts = 0;
+        int numFailed = 0;
+        for(size_t i = 0; i < order.size(); ++i) {
+            if(i > 0)
+                DOCTEST_ITERATE_THROUGH_REPORTERS(test_case_reenter, tc);
+            for(auto& e : order[i]->events)
+                replay(p, e);
+
+            p->failure_flags |= order[i]->failure_flags;
+            asserts += order[i]->asserts;
+            numFailed += order[i]->failed;
+            if(p->abort_after > 0 && p->numAssertsFailed + numFailed >= p->abort_after) {
+                p->failure_flags |= TestCaseFailureReason::TooManyFailedAsserts;
+                break;
+            }
+        }
+        // on top of what threads started by the test case have asserted after their pass ended
+        p->assertCounters.reset(p->assertCounters.numAsserts() + asserts,
+                                p->assertCounters.numAssertsFailed() + numFailed);
+    }
+#endif // DOCTEST_CONFIG_NO_MULTITHREADING
+} // namespace
+
+#ifndef DOCTEST_CONFIG_NO_MULTITHREADING
+namespace detail {
+    bool logOnOwnThread(const AssertData& ad) {
+        ThreadLog* log = getOwnThreadLog();
+        if(log)
+            log->log_assert(ad);
+        return log != nullptr;
+    }
+
+    bool logOnOwnThread(const MessageData& mb) {
+        ThreadLog* log = getOwnThreadLog();
+        if(log)
+            log->log_message(mb);
+        return log != nullptr;
+    }
+
+    // the events are delivered thread by thread (in the order of their first events) so the output
+    // of every thread stays together - the contexts of the delivering thread don't get mixed in.
+    // Only the logs of the given state are taken - a thread gets a new owner with its next event.
+    void deliverThreadLogs(ContextState* p) {
+        if(!p->thread_logs)
+            return;
+
+        std::vector<RecordedEvent> events;
+        {
+            ThreadLogs& data = getThreadLogs();
+            DOCTEST_LOCK_MUTEX(data.mutex)
+            for(size_t i = 0; i < data.logs.size();) {
+                ThreadLog& log      = *data.logs[i];
+                bool       finished = false;
+                {
+                    DOCTEST_LOCK_MUTEX(log.mutex)
+                    if(log.owner == p) {
+                        for(auto& e : log.events)
+                            events.push_back(std::move(e));
+                        log.events.clear();
+                        log.owner = nullptr;
+                    }
+                    finished = log.finished && log.owner == nullptr;
+                }
+                if(finished) {
+                    delete data.logs[i];
+                    data.logs.erase(data.logs.begin() + static_cast<std::ptrdiff_t>(i));
+                } else
+                    ++i;
+            }
+        }
+        if(events.empty())
+            return;
+
+        const std::vector<IContextScope*> contexts(g_infoContexts.data(),
+                                                   g_infoContexts.data() + g_infoContexts.size());
+        g_infoContexts.pop_back(g_infoContexts.size());
+        const std::vector<String> stringified = p->stringifiedContexts;
+
+        for(auto& e : events)
+            replay(p, e);
+
+        for(auto& c : contexts)
+            g_infoContexts.push_back(c);
+        p->stringifiedContexts = stringified;
+    }
+} // namespace detail
+#endif // DOCTEST_CONFIG_NO_MULTITHREADING
+
+namespace {
+    using namespace detail;
+
+    bool passesFilters(const ContextState* p, const TestCase& tc) {
+        if(tc.m_skip && !p->no_skip)
+            return false;
+
+        return p->filterMatchers[0].matches(tc.m_file.c_str(), true) &&
+               !p->filterMatchers[1].matches(tc.m_file.c_str(), false) &&
+               p->filterMatchers[2].matches(tc.m_test_suite, true) &&
+               !p->filterMatchers[3].matches(tc.m_test_suite, false) &&
+               p->filterMatchers[4].matches(tc.m_name, true) &&
+               !p->filterMatchers[5].matches(tc.m_name, false);
+    }
+
+    // picks the test cases of the current shard (see --shard-count) out of the ones passing the
+    // filters - every shard has to come up with the same partition so only the test cases and the
+    // durations file are used (and not the order of the test cases which depends on --order-by)
+    std::unordered_set<const TestCase*> selectShard(const ContextState* p,
+                                                    const std::vector<const TestCase*>& tests) {
+        struct Candidate
+        {
+            const TestCase*    tc;
+            unsigned long long id;
+            double             seconds;
+        };
+
+        std::vector<Candidate> candidates;
+        double                 known = 0;
+        size_t                 numKnown = 0;
+        for(auto& curr : tests) {
+            if(!passesFilters(p, *curr))
+                continue;
+            const double seconds = p->durationHistory.get(*curr);
+            candidates.push_back({curr, DurationHistory::id(*curr), seconds});
+            if(seconds >= 0) {
+                known += seconds;
+                numKnown++;
+            }
+        }
+
+        const auto count = unsigned(p->shard_count);
+        const auto index = unsigned(p->shard_index);
+
+        std::unordered_set<const TestCase*> res;
+
+        // without any history the hash of the test case decides - adding or removing test cases
+        // doesn't move the others to a different shard this way. The low bits of FNV-1a depend
+        // only on the low bits of the input bytes so the hash is mixed before taking the modulo.
+        if(numKnown == 0) {
+            for(auto& curr : candidates)
+                if(mix(curr.id) % count == index)
+                    res.insert(curr.tc);
+            return res;
+        }
+
+        // otherwise the longest test case goes to the shard with the least work so far - the ones
+        // which haven't been run before are assumed to take the average time
+        for(auto& curr : candidates)
+            if(curr.seconds < 0)
+                curr.seconds = known / double(numKnown);
+
+        std::sort(candidates.begin(), candidates.end(), [](const Candidate& lhs, const Candidate& rhs) {
+            if(lhs.seconds > rhs.seconds || rhs.seconds > lhs.seconds)
+                return lhs.seconds > rhs.seconds;
+            if(lhs.id != rhs.id)
+                return lhs.id < rhs.id;
+            return fileOrderComparator(lhs.tc, rhs.tc);
+        });
+
+        std::vector<double> load(count, 0);
+        for(auto& curr : candidates) {
+            const auto shard = unsigned(std::min_element(load.begin(), load.end()) - load.begin());
+            load[shard] += curr.seconds;
+            if(shard == index)
+                res.insert(curr.tc);
+        }
+        return res;
+    }
+} // namespace
+
+// the main function that does all the filtering and test running
+int Context::run() {
+    using namespace detail;
+
+    // save the old context state in case such was setup - for using asserts out of a testing context
+    auto old_cs = g_cs;
+    // this is the current contest
+    g_cs               = p;
+    is_running_in_test = true;
+
+    const bool old_doctest_thread = g_doctest_thread;
+    g_doctest_thread              = true;
+
+    g_no_colors = p->no_colors;
+#if defined(DOCTEST_CONFIG_COLORS_ANSI) || defined(DOCTEST_CONFIG_COLORS_WINDOWS)
+    g_stdout_is_terminal = -1;
+#endif // DOCTEST_CONFIG_COLORS_ANSI || DOCTEST_CONFIG_COLORS_WINDOWS
+    p->resetRunData();
+
+    std::vector<char> fbuf;
+    std::fstream      fstr;
+    if(p->cout == nullptr) {
+        if(p->quiet) {
+            p->cout = &discardOut;
+        } else if(p->out.size()) {
+            // to a file if specified - the output of the binary reporter shouldn't get translated
+            auto mode = std::fstream::out;
+            if(matchesAny("binary", p->filters[8], false, p->case_sensitive))
+                mode |= std::fstream::binary;
+            // a large buffer so the file is written in few big chunks (it has to be set before
+            // the file is opened to have an effect)
+            if(p->out_buffer > 0) {
+                fbuf.resize(static_cast<size_t>(p->out_buffer) * 1024);
+                fstr.rdbuf()->pubsetbuf(fbuf.data(), static_cast<std::streamsize>(fbuf.size()));
+            }
+            fstr.open(p->out.c_str(), mode);
+            p->cout = &fstr;
+        } else {
+#ifndef DOCTEST_CONFIG_NO_INCLUDE_IOSTREAM
+            // stdout by default
+            p->cout = &std::cout;
+#else // DOCTEST_CONFIG_NO_INCLUDE_IOSTREAM
+            return EXIT_FAILURE;
+#endif // DOCTEST_CONFIG_NO_INCLUDE_IOSTREAM
+        }
+    }
+
+    FatalConditionHandler::allocateAltStackMem();
+
+#ifndef DOCTEST_CONFIG_NO_MULTITHREADING
+    Watchdog watchdog;
+    if(p->test_timeout > 0)
+        p->watchdog = &watchdog;
+#endif // DOCTEST_CONFIG_NO_MULTITHREADING
+
+    auto cleanup_and_return = [&]() {
+        FatalConditionHandler::freeAltStackMem();
+
+#ifndef DOCTEST_CONFIG_NO_MULTITHREADING
+        p->watchdog = nullptr;
+#endif // DOCTEST_CONFIG_NO_MULTITHREADING
+
+        if(fstr.is_open())
+            fstr.close();
+
+        // restore context
+        g_cs               = old_cs;
+        is_running_in_test = false;
+        g_doctest_thread   = old_doctest_thread;
+
+        // we have to free the reporters which were allocated when the run started
+        for(auto& curr : p->reporters_currently_used)
+            delete curr;
+        p->reporters_currently_used.clear();
+
+        if(p->numTestCasesFailed && !p->no_exitcode)
+            return EXIT_FAILURE;
+        return EXIT_SUCCESS;
+    };
+
+    // setup default reporter if none is given through the command line
+    if(p->filters[8].empty())
+        p->filters[8].push_back("console");
+
+    // check to see if any of the registered reporters has been selected
+    for(auto& curr : getReporters()) {
+        if(matchesAny(curr.first.second.c_str(), p->filters[8], false, p->case_sensitive))
             p->reporters_currently_used.push_back(curr.second(*g_cs));
     }
 
@@ -3796,11 +7918,28 @@ int Context::run() {
     for(auto& curr : getListeners())
         p->reporters_currently_used.insert(p->reporters_currently_used.begin(), curr.second(*g_cs));
 
+    // the debugger detection can be slow (reading /proc/self/status on Linux) so by default it's
+    // done only once here and not for every failed assert
+    if(p->debugger_check.compare("always", true) == 0) {
+        g_debuggerCheck = debuggerCheck::always;
+    } else if(p->debugger_check.compare("never", true) == 0) {
+        g_debuggerCheck = debuggerCheck::never;
+    } else {
+        g_debuggerCheck = debuggerCheck::once;
+        redetectDebugger();
+    }
+
 #ifdef DOCTEST_PLATFORM_WINDOWS
     if(isDebuggerActive() && p->no_debug_output == false)
         p->reporters_currently_used.push_back(new DebugOutputWindowReporter(*g_cs));
 #endif // DOCTEST_PLATFORM_WINDOWS
 
+    // passing asserts go through the reporters only if at least one of them is interested
+    p->report_successful_asserts = false;
+    for(auto& curr : p->reporters_currently_used)
+        if(curr->wants_successful_asserts())
+            p->report_successful_asserts = true;
+
     // handle version, help and no_run
     if(p->no_run || p->version || p->help || p->list_reporters) {
         DOCTEST_ITERATE_THROUGH_REPORTERS(report_query, QueryData());
@@ -3808,6 +7947,22 @@ int Context::run() {
         return cleanup_and_return();
     }
 
+    // report the events recorded by the binary reporter instead of running the tests
+    if(p->replay.size()) {
+        if(!replayBinaryStream(p)) {
+            *p->cout << Color::Cyan << "[doctest] " << Color::None << "\"" << p->replay
+                     << "\" isn't the output of the binary reporter\n";
+            p->numTestCasesFailed = 1;
+        }
+        return cleanup_and_return();
+    }
+
+    // the test cases of DOCTEST_CONFIG_TEST_SECTION haven't been registered by static initializers
+    registerTestSection();
+
+    if(p->durations_file.size())
+        p->durationHistory.load(p->durations_file);
+
     std::vector<const TestCase*> testArray;
     for(auto& curr : getRegisteredTests())
         testArray.push_back(&curr);
@@ -3835,38 +7990,78 @@ int Context::run() {
                 first[idxToSwap] = temp;
             }
         } else if(p->order_by.compare("none", true) == 0) {
-            // means no sorting - beneficial for death tests which call into the executable
-            // with a specific test case in mind - we don't want to slow down the startup times
+            // means no sorting (the order of registration) - beneficial for death tests which call
+            // into the executable with a specific test case in mind - we don't want to slow down
+            // the startup times
+        } else if(p->order_by.compare("duration", true) == 0) {
+            // longest first so the long poles of a parallel run are started as early as possible -
+            // test cases without a recorded duration might be long too so they go before the rest
+            std::sort(testArray.begin(), testArray.end(), fileOrderComparator);
+            std::vector<std::pair<double, const TestCase*>> byDuration;
+            for(auto& curr : testArray) {
+                const double seconds = p->durationHistory.get(*curr);
+                byDuration.emplace_back(seconds < 0 ? DBL_MAX : seconds, curr);
+            }
+            std::stable_sort(byDuration.begin(), byDuration.end(),
+                             [](const std::pair<double, const TestCase*>& lhs,
+                                const std::pair<double, const TestCase*>& rhs) {
+                                 return lhs.first > rhs.first;
+                             });
+            for(size_t i = 0; i < byDuration.size(); ++i)
+                testArray[i] = byDuration[i].second;
         }
     }
 
+    // the filters are compiled only now since they can be changed through the API until the run
+    for(size_t i = 0; i < p->filterMatchers.size(); ++i)
+        p->filterMatchers[i].compile(p->filters[i], p->case_sensitive);
+
+    // the shard is selected upfront since it depends on all the test cases passing the filters
+    std::unordered_set<const TestCase*> shard;
+    if(p->shard_count > 1) {
+        if(p->shard_index < 0 || p->shard_index >= p->shard_count) {
+            *p->cout << Color::Cyan << "[doctest] " << Color::None
+                     << "--shard-index should be in the range [0, --shard-count)\n";
+            p->numTestCasesFailed = 1;
+            return cleanup_and_return();
+        }
+        shard = selectShard(p, testArray);
+    }
+
     std::set<String> testSuitesPassingFilt;
 
     bool                             query_mode = p->count || p->list_test_cases || p->list_test_suites;
     std::vector<const TestCaseData*> queryResults;
 
+#ifndef DOCTEST_CONFIG_NO_MULTITHREADING
+    // the reporters get deleted along with the one replacing them (in cleanup_and_return)
+    if(!query_mode && p->async_reporters) {
+        auto async = new AsyncReporter(p, 4096);
+        p->reporters_currently_used.assign(1, async);
+    }
+#endif // DOCTEST_CONFIG_NO_MULTITHREADING
+
     if(!query_mode)
         DOCTEST_ITERATE_THROUGH_REPORTERS(test_run_start, DOCTEST_EMPTY);
 
+#ifndef DOCTEST_CONFIG_NO_MULTITHREADING
+    // the events of skipped test cases are queued as well so they are reported in the same order
+    ParallelTestRunner parallelRunner(p);
+#ifdef DOCTEST_CONFIG_POSIX_FORK
+    const bool isolated = p->isolate;
+#else  // DOCTEST_CONFIG_POSIX_FORK
+    const bool isolated = false;
+#endif // DOCTEST_CONFIG_POSIX_FORK
+    const bool run_in_parallel = !query_mode && (p->parallel > 1 || isolated);
+#endif // DOCTEST_CONFIG_NO_MULTITHREADING
+
     // invoke the registered functions if they match the filter criteria (or just count them)
     for(auto& curr : testArray) {
         const auto& tc = *curr;
 
-        bool skip_me = false;
-        if(tc.m_skip && !p->no_skip)
-            skip_me = true;
+        bool skip_me = !passesFilters(p, tc);
 
-        if(!matchesAny(tc.m_file.c_str(), p->filters[0], true, p->case_sensitive))
-            skip_me = true;
-        if(matchesAny(tc.m_file.c_str(), p->filters[1], false, p->case_sensitive))
-            skip_me = true;
-        if(!matchesAny(tc.m_test_suite, p->filters[2], true, p->case_sensitive))
-            skip_me = true;
-        if(matchesAny(tc.m_test_suite, p->filters[3], false, p->case_sensitive))
-            skip_me = true;
-        if(!matchesAny(tc.m_name, p->filters[4], true, p->case_sensitive))
-            skip_me = true;
-        if(matchesAny(tc.m_name, p->filters[5], false, p->case_sensitive))
+        if(!skip_me && p->shard_count > 1 && shard.count(&tc) == 0)
             skip_me = true;
 
         if(!skip_me)
@@ -3878,6 +8073,11 @@ int Context::run() {
             skip_me = true;
 
         if(skip_me) {
+#ifndef DOCTEST_CONFIG_NO_MULTITHREADING
+            if(run_in_parallel)
+                parallelRunner.add(tc, true);
+            else
+#endif // DOCTEST_CONFIG_NO_MULTITHREADING
             if(!query_mode)
                 DOCTEST_ITERATE_THROUGH_REPORTERS(test_case_skipped, tc);
             continue;
@@ -3903,81 +8103,34 @@ int Context::run() {
             continue;
         }
 
-        // execute the test if it passes all the filtering
-        {
-            p->currentTest = &tc;
-
-            p->failure_flags = TestCaseFailureReason::None;
-            p->seconds       = 0;
-
-            // reset atomic counters
-            p->numAssertsFailedCurrentTest_atomic = 0;
-            p->numAssertsCurrentTest_atomic       = 0;
-
-            p->fullyTraversedSubcases.clear();
-
-            DOCTEST_ITERATE_THROUGH_REPORTERS(test_case_start, tc);
-
-            p->timer.start();
-
-            bool run_test = true;
-
-            do {
-                // reset some of the fields for subcases (except for the set of fully passed ones)
-                p->reachedLeaf = false;
-                // May not be empty if previous subcase exited via exception.
-                p->subcaseStack.clear();
-                p->currentSubcaseDepth = 0;
-
-                p->shouldLogCurrentException = true;
-
-                // reset stuff for logging with INFO()
-                p->stringifiedContexts.clear();
-
-#ifndef DOCTEST_CONFIG_NO_EXCEPTIONS
-                try {
-#endif // DOCTEST_CONFIG_NO_EXCEPTIONS
-// MSVC 2015 diagnoses fatalConditionHandler as unused (because reset() is a static method)
-DOCTEST_MSVC_SUPPRESS_WARNING_WITH_PUSH(4101) // unreferenced local variable
-                    FatalConditionHandler fatalConditionHandler; // Handle signals
-                    // execute the test
-                    tc.m_test();
-                    fatalConditionHandler.reset();
-DOCTEST_MSVC_SUPPRESS_WARNING_POP
-#ifndef DOCTEST_CONFIG_NO_EXCEPTIONS
-                } catch(const TestFailureException&) {
-                    p->failure_flags |= TestCaseFailureReason::AssertFailure;
-                } catch(...) {
-                    DOCTEST_ITERATE_THROUGH_REPORTERS(test_case_exception,
-                                                      {translateActiveException(), false});
-                    p->failure_flags |= TestCaseFailureReason::Exception;
-                }
-#endif // DOCTEST_CONFIG_NO_EXCEPTIONS
-
-                // exit this loop if enough assertions have failed - even if there are more subcases
-                if(p->abort_after > 0 &&
-                   p->numAssertsFailed + p->numAssertsFailedCurrentTest_atomic >= p->abort_after) {
-                    run_test = false;
-                    p->failure_flags |= TestCaseFailureReason::TooManyFailedAsserts;
-                }
-
-                if(!p->nextSubcaseStack.empty() && run_test)
-                    DOCTEST_ITERATE_THROUGH_REPORTERS(test_case_reenter, tc);
-                if(p->nextSubcaseStack.empty())
-                    run_test = false;
-            } while(run_test);
+#ifndef DOCTEST_CONFIG_NO_MULTITHREADING
+        if(run_in_parallel) {
+            parallelRunner.add(tc, false);
+            continue;
+        }
+#endif // DOCTEST_CONFIG_NO_MULTITHREADING
 
-            p->finalizeTestCaseData();
+        // execute the test if it passes all the filtering
+        runTestCase(p, tc);
+        if(p->durations_file.size())
+            p->durationHistory.record(tc, p->seconds);
 
-            DOCTEST_ITERATE_THROUGH_REPORTERS(test_case_end, *g_cs);
+        // stop executing tests if enough assertions have failed
+        if(p->abort_after > 0 && p->numAssertsFailed >= p->abort_after)
+            break;
+    }
 
-            p->currentTest = nullptr;
+#ifndef DOCTEST_CONFIG_NO_MULTITHREADING
+    if(run_in_parallel)
+        parallelRunner.run();
+#endif // DOCTEST_CONFIG_NO_MULTITHREADING
 
-            // stop executing tests if enough assertions have failed
-            if(p->abort_after > 0 && p->numAssertsFailed >= p->abort_after)
-                break;
-        }
-    }
+    // the shards only read the durations - they run at the same time and each one has measured
+    // just its own test cases so they all have to see the same history to agree on the partition
+    if(!query_mode && p->durations_file.size() && p->shard_count <= 1 &&
+       !p->durationHistory.save(p->durations_file))
+        *p->cout << Color::Cyan << "[doctest] " << Color::None << "couldn't write the durations to \""
+                 << p->durations_file << "\"\n";
 
     if(!query_mode) {
         DOCTEST_ITERATE_THROUGH_REPORTERS(test_run_end, *g_cs);
@@ -3994,14 +8147,14 @@ DOCTEST_MSVC_SUPPRESS_WARNING_POP
 
 DOCTEST_DEFINE_INTERFACE(IReporter)
 
-int IReporter::get_num_active_contexts() { return detail::g_infoContexts.size(); }
+int IReporter::get_num_active_contexts() { return static_cast<int>(detail::g_infoContexts.size()); }
 const IContextScope* const* IReporter::get_active_contexts() {
-    return get_num_active_contexts() ? &detail::g_infoContexts[0] : nullptr;
+    return get_num_active_contexts() ? detail::g_infoContexts.data() : nullptr;
 }
 
-int IReporter::get_num_stringified_contexts() { return detail::g_cs->stringifiedContexts.size(); }
+int IReporter::get_num_stringified_contexts() { return detail::currentState()->stringifiedContexts.size(); }
 const String* IReporter::get_stringified_contexts() {
-    return get_num_stringified_contexts() ? &detail::g_cs->stringifiedContexts[0] : nullptr;
+    return get_num_stringified_contexts() ? &detail::currentState()->stringifiedContexts[0] : nullptr;
 }
 
 namespace detail {
@@ -4015,6 +8168,244 @@ namespace detail {
 
 } // namespace doctest
 
+#ifdef DOCTEST_CONFIG_TRACK_ALLOCATIONS
+namespace doctest {
+namespace {
+    // the size of a block as requested and as held by the allocator
+    void countAllocation(std::size_t requested, std::size_t held) {
+        auto& counters = detail::g_allocations;
+        ++counters.count;
+        counters.bytes += requested;
+        counters.live += static_cast<long long>(held);
+        if(counters.live > counters.peak)
+            counters.peak = counters.live;
+    }
+
+    void countDeallocation(std::size_t held) {
+        detail::g_allocations.live -= static_cast<long long>(held);
+    }
+
+#ifndef __GLIBC__
+    // the size of a block is kept in a header in front of it which doesn't break the alignment
+    DOCTEST_CONSTEXPR std::size_t allocationHeader = alignof(std::max_align_t);
+
+    void* allocateTracked(std::size_t size) {
+        void* const block = std::malloc(size + allocationHeader);
+        if(!block)
+            return nullptr;
+        std::memcpy(block, &size, sizeof(size));
+        countAllocation(size, size);
+        return static_cast<char*>(block) + allocationHeader;
+    }
+
+    void freeTracked(void* ptr) {
+        if(!ptr)
+            return;
+        void* const block = static_cast<char*>(ptr) - allocationHeader;
+        std::size_t size;
+        std::memcpy(&size, block, sizeof(size));
+        countDeallocation(size);
+        std::free(block);
+    }
+
+#ifdef __cpp_aligned_new
+    // an over-aligned block is placed in a larger one - the address of the larger block and the
+    // size are kept right in front of it
+    struct AlignedHeader
+    {
+        void*       block;
+        std::size_t size;
+    };
+
+    void* allocateAlignedTracked(std::size_t size, std::size_t alignment) {
+        void* const block = std::malloc(size + alignment + sizeof(AlignedHeader));
+        if(!block)
+            return nullptr;
+        const auto start = reinterpret_cast<std::uintptr_t>(block) + sizeof(AlignedHeader);
+        void* const ptr  = reinterpret_cast<void*>((start + alignment - 1) & ~(alignment - 1));
+        const AlignedHeader header = {block, size};
+        std::memcpy(static_cast<char*>(ptr) - sizeof(header), &header, sizeof(header));
+        countAllocation(size, size);
+        return ptr;
+    }
+
+    void freeAlignedTracked(void* ptr) {
+        if(!ptr)
+            return;
+        AlignedHeader header;
+        std::memcpy(&header, static_cast<char*>(ptr) - sizeof(header), sizeof(header));
+        countDeallocation(header.size);
+        std::free(header.block);
+    }
+#endif // __cpp_aligned_new
+
+    // the alignment is 0 for the default one
+    void* newTracked(std::size_t size, std::size_t alignment = 0) {
+        for(;;) {
+#ifdef __cpp_aligned_new
+            if(void* const ptr = alignment ? allocateAlignedTracked(size, alignment)
+                                           : allocateTracked(size))
+                return ptr;
+#else  // __cpp_aligned_new
+            (void)alignment;
+            if(void* const ptr = allocateTracked(size))
+                return ptr;
+#endif // __cpp_aligned_new
+            const std::new_handler handler = std::get_new_handler();
+            if(!handler) {
+#ifndef DOCTEST_CONFIG_NO_EXCEPTIONS
+                throw std::bad_alloc();
+#else  // DOCTEST_CONFIG_NO_EXCEPTIONS
+                std::abort();
+#endif // DOCTEST_CONFIG_NO_EXCEPTIONS
+            }
+            handler();
+        }
+    }
+#endif // __GLIBC__
+} // namespace
+} // namespace doctest
+
+#ifdef __GLIBC__
+// the whole malloc family is interposed so the allocations of C code are counted too (operator new
+// calls malloc) - the memory held by a block is its usable size
+DOCTEST_CLANG_SUPPRESS_WARNING_WITH_PUSH("-Wreserved-identifier")
+extern "C" {
+void* __libc_malloc(size_t);
+void* __libc_calloc(size_t, size_t);
+void* __libc_realloc(void*, size_t);
+void* __libc_memalign(size_t, size_t);
+void* __libc_valloc(size_t);
+void* __libc_pvalloc(size_t);
+void  __libc_free(void*);
+
+void* malloc(size_t size) __THROW {
+    void* const ptr = __libc_malloc(size);
+    if(ptr)
+        doctest::countAllocation(size, malloc_usable_size(ptr));
+    return ptr;
+}
+
+// the size of an array of blocks fails like in glibc if it overflows
+void* calloc(size_t num, size_t size) __THROW {
+    if(size != 0 && num > SIZE_MAX / size) {
+        errno = ENOMEM;
+        return nullptr;
+    }
+    void* const ptr = __libc_calloc(num, size);
+    if(ptr)
+        doctest::countAllocation(num * size, malloc_usable_size(ptr));
+    return ptr;
+}
+
+void* realloc(void* ptr, size_t size) __THROW {
+    const size_t held = ptr ? malloc_usable_size(ptr) : 0;
+    void* const  res  = __libc_realloc(ptr, size);
+    // the old block is left as it is if a new one can't be allocated
+    if(res || size == 0)
+        doctest::countDeallocation(held);
+    if(res)
+        doctest::countAllocation(size, malloc_usable_size(res));
+    return res;
+}
+
+void* reallocarray(void* ptr, size_t num, size_t size) __THROW {
+    if(size != 0 && num > SIZE_MAX / size) {
+        errno = ENOMEM;
+        return nullptr;
+    }
+    return realloc(ptr, num * size);
+}
+
+void* memalign(size_t alignment, size_t size) __THROW {
+    void* const ptr = __libc_memalign(alignment, size);
+    if(ptr)
+        doctest::countAllocation(size, malloc_usable_size(ptr));
+    return ptr;
+}
+
+// the blocks of these are freed with free() as well so they can't bypass the counting
+void* valloc(size_t size) __THROW {
+    void* const ptr = __libc_valloc(size);
+    if(ptr)
+        doctest::countAllocation(size, malloc_usable_size(ptr));
+    return ptr;
+}
+
+void* pvalloc(size_t size) __THROW {
+    void* const ptr = __libc_pvalloc(size);
+    if(ptr)
+        doctest::countAllocation(size, malloc_usable_size(ptr));
+    return ptr;
+}
+
+void* aligned_alloc(size_t alignment, size_t size) __THROW { return memalign(alignment, size); }
+
+int posix_memalign(void** out, size_t alignment, size_t size) __THROW {
+    if(alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0)
+        return EINVAL;
+    void* const ptr = memalign(alignment, size);
+    if(!ptr)
+        return ENOMEM;
+    *out = ptr;
+    return 0;
+}
+
+void free(void* ptr) __THROW {
+    if(ptr)
+        doctest::countDeallocation(malloc_usable_size(ptr));
+    __libc_free(ptr);
+}
+} // extern "C"
+DOCTEST_CLANG_SUPPRESS_WARNING_POP
+#else // __GLIBC__
+void* operator new(std::size_t size) { return doctest::newTracked(size); }
+void* operator new[](std::size_t size) { return doctest::newTracked(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return doctest::allocateTracked(size);
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return doctest::allocateTracked(size);
+}
+void operator delete(void* ptr) noexcept { doctest::freeTracked(ptr); }
+void operator delete[](void* ptr) noexcept { doctest::freeTracked(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { doctest::freeTracked(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { doctest::freeTracked(ptr); }
+#ifdef __cpp_sized_deallocation
+void operator delete(void* ptr, std::size_t) noexcept { doctest::freeTracked(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { doctest::freeTracked(ptr); }
+#endif // __cpp_sized_deallocation
+#ifdef __cpp_aligned_new
+void* operator new(std::size_t size, std::align_val_t al) {
+    return doctest::newTracked(size, static_cast<std::size_t>(al));
+}
+void* operator new[](std::size_t size, std::align_val_t al) {
+    return doctest::newTracked(size, static_cast<std::size_t>(al));
+}
+void* operator new(std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return doctest::allocateAlignedTracked(size, static_cast<std::size_t>(al));
+}
+void* operator new[](std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return doctest::allocateAlignedTracked(size, static_cast<std::size_t>(al));
+}
+void operator delete(void* ptr, std::align_val_t) noexcept { doctest::freeAlignedTracked(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { doctest::freeAlignedTracked(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    doctest::freeAlignedTracked(ptr);
+}
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    doctest::freeAlignedTracked(ptr);
+}
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+    doctest::freeAlignedTracked(ptr);
+}
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept {
+    doctest::freeAlignedTracked(ptr);
+}
+#endif // __cpp_aligned_new
+#endif // __GLIBC__
+#endif // DOCTEST_CONFIG_TRACK_ALLOCATIONS
+
 #endif // DOCTEST_CONFIG_DISABLE
 
 #ifdef DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
@@ -283,6 +283,19 @@ DOCTEST_MSVC_SUPPRESS_WARNING(4623) // default constructor was implicitly define
 #undef DOCTEST_CONFIG_POSIX_SIGNALS
 #endif // DOCTEST_CONFIG_NO_POSIX_SIGNALS
 
+#if !defined(_WIN32) && !defined(__QNX__) && !defined(DOCTEST_CONFIG_POSIX_FORK) &&                \
+        !defined(__EMSCRIPTEN__) && !defined(__wasi__)
+#define DOCTEST_CONFIG_POSIX_FORK
+#endif // _WIN32
+#if defined(DOCTEST_CONFIG_NO_POSIX_FORK) && defined(DOCTEST_CONFIG_POSIX_FORK)
+#undef DOCTEST_CONFIG_POSIX_FORK
+#endif // DOCTEST_CONFIG_NO_POSIX_FORK
+
+// the linker provides the bounds of the section with the test cases only for ELF binaries
+#if defined(DOCTEST_CONFIG_TEST_SECTION) && !defined(__ELF__)
+#undef DOCTEST_CONFIG_TEST_SECTION
+#endif // DOCTEST_CONFIG_TEST_SECTION
+
 #ifndef DOCTEST_CONFIG_NO_EXCEPTIONS
 #if !defined(__cpp_exceptions) && !defined(__EXCEPTIONS) && !defined(_CPPUNWIND)                   \
         || defined(__wasi__)
@@ -814,6 +827,7 @@ struct DOCTEST_INTERFACE TestCaseData
     bool        m_no_output;
     bool        m_may_fail;
     bool        m_should_fail;
+    bool        m_parallel_subcases;
     int         m_expected_failures;
     double      m_timeout;
 };
@@ -867,6 +881,58 @@ struct DOCTEST_INTERFACE MessageData
     assertType::Enum m_severity;
 };
 
+struct DOCTEST_INTERFACE BenchmarkStats
+{
+    String             m_name;
+    const char*        m_file;
+    int                m_line;
+    int                m_samples;    // the number of measured samples
+    unsigned long long m_iterations; // the number of iterations in each sample
+
+    // all durations are in nanoseconds per iteration
+    double m_mean;
+    double m_median;
+    double m_standard_deviation;
+    double m_mean_lower_bound; // the bootstrapped 95% confidence interval of the mean
+    double m_mean_upper_bound;
+};
+
+namespace PerfCounter {
+    enum Enum
+    {
+        Cycles,       // hardware
+        Instructions, // hardware
+        BranchMisses, // hardware
+        CacheMisses,  // hardware
+        TaskClock,    // software - nanoseconds on the CPU
+        PageFaults,   // software
+        Count
+    };
+} // namespace PerfCounter
+
+namespace PerfCounterScope {
+    enum Enum
+    {
+        TestCase,
+        Subcase,
+        Benchmark
+    };
+} // namespace PerfCounterScope
+
+// the performance counters of the thread executing a test case, a subcase or a benchmark (see the
+// --perf-counters option) - the values for a benchmark are per iteration of its measured batches
+struct DOCTEST_INTERFACE PerfCounterStats
+{
+    PerfCounterScope::Enum m_scope;
+    String                 m_name;
+    const char*            m_file;
+    int                    m_line;
+    unsigned               m_measured; // a bit (1 << PerfCounter::Enum) for each available counter
+    double                 m_values[PerfCounter::Count];
+
+    bool measured(PerfCounter::Enum counter) const { return (m_measured >> counter) & 1; }
+};
+
 struct DOCTEST_INTERFACE SubcaseSignature
 {
     String      m_name;
@@ -904,6 +970,18 @@ struct ContextOptions //!OCLINT too many fields
 
     int abort_after;           // stop tests after this many failed assertions
     int subcase_filter_levels; // apply the subcase filters for the first N levels
+    int parallel;              // run the test cases on this many workers
+    int benchmark_samples;     // the number of samples measured for each benchmark
+    int benchmark_resamples;   // the number of bootstrap resamples for the confidence interval
+    int benchmark_warmup;      // the milliseconds each benchmark runs before being measured
+    String debugger_check;     // when to check if a debugger is attached - once/always/never
+    String replay;             // the output of the binary reporter to feed to the reporters
+    String durations_file;     // the durations of test cases are read from and saved to this file
+    int    slowest;            // summarize the durations and list the N slowest test cases
+    int    shard_count;        // split the test cases passing the filters into this many shards
+    int    shard_index;        // the shard to execute (0-based)
+    int    test_timeout;       // a watchdog stops a test case running for longer than this (seconds)
+    int    out_buffer;         // the size of the buffer of the --out file (in KiB)
 
     bool success;              // include successful assertions in output
     bool case_sensitive;       // if filtering should be case sensitive
@@ -927,6 +1005,11 @@ struct ContextOptions //!OCLINT too many fields
     bool no_debug_output;      // no output in the debug console when a debugger is attached
     bool no_skipped_summary;   // don't print "skipped" in the summary !!! UNDOCUMENTED !!!
     bool no_time_in_output;    // omit any time/timestamps from output !!! UNDOCUMENTED !!!
+    bool isolate;              // run the test cases of a parallel run in forked worker processes
+    bool resource_summary;     // measure the resources used by each test case and summarize them
+    bool perf_counters;        // measure test cases, subcases and benchmarks with perf_event_open()
+    bool async_reporters;      // deliver the events to the reporters on a thread of their own
+    bool thread_logs;          // log the asserts of threads started by the tests until the subcase ends
 
     bool help;             // to print the help
     bool version;          // to print the version
@@ -1302,6 +1385,37 @@ DOCTEST_INTERFACE String toString(IsNaN<float> in);
 DOCTEST_INTERFACE String toString(IsNaN<double> in);
 DOCTEST_INTERFACE String toString(IsNaN<double long> in);
 
+namespace detail {
+    DOCTEST_INTERFACE void useBenchmarkValue(const volatile void* in);
+} // namespace detail
+
+// prevents the compiler from optimizing away the computation of a value in a benchmark
+#if DOCTEST_GCC || DOCTEST_CLANG
+template <typename T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+template <typename T>
+inline void do_not_optimize(T& value) {
+#if DOCTEST_CLANG
+    asm volatile("" : "+r,m"(value) : : "memory");
+#else  // DOCTEST_CLANG
+    asm volatile("" : "+m,r"(value) : : "memory");
+#endif // DOCTEST_CLANG
+}
+
+// forces all pending writes to memory to be considered observable
+inline void clobber() { asm volatile("" : : : "memory"); }
+#else  // DOCTEST_GCC || DOCTEST_CLANG
+template <typename T>
+inline void do_not_optimize(const T& value) {
+    detail::useBenchmarkValue(&value);
+}
+
+inline void clobber() { detail::useBenchmarkValue(nullptr); }
+#endif // DOCTEST_GCC || DOCTEST_CLANG
+
 #ifndef DOCTEST_CONFIG_DISABLE
 
 namespace detail {
@@ -1348,6 +1462,73 @@ namespace detail {
             bool checkFilters();
     };
 
+    struct DOCTEST_INTERFACE Benchmark
+    {
+        struct State;
+
+        State*             m_state;
+        unsigned long long m_batches = 0; // the number of measured batches
+
+        Benchmark(const String& name, const char* file, int line);
+        Benchmark(const Benchmark&) = delete;
+        Benchmark(Benchmark&&) = delete;
+        Benchmark& operator=(const Benchmark&) = delete;
+        Benchmark& operator=(Benchmark&&) = delete;
+        ~Benchmark();
+
+        // DOCTEST_BENCHMARK - every call of the function is a single iteration
+        // DOCTEST_BENCHMARK_ADVANCED - the function is called once for each batch of iterations
+        template <typename F>
+        void operator=(F&& fun); // NOLINT(misc-unconventional-assign-operator)
+
+        // returns the number of iterations in the next batch and starts measuring it
+        unsigned long long startBatch();
+        // stops measuring the current batch - false when the benchmark has finished
+        bool endBatch();
+    };
+
+    // checks the number of heap allocations made by the calling thread during its lifetime - they
+    // are counted only when DOCTEST_CONFIG_TRACK_ALLOCATIONS is defined for the implementation
+    struct DOCTEST_INTERFACE AllocationScope
+    {
+        const char*        m_file;
+        int                m_line;
+        const char*        m_expr;
+        unsigned long long m_max;
+        unsigned long long m_start;
+
+        AllocationScope(const char* file, int line, const char* expr, unsigned long long max);
+        AllocationScope(const AllocationScope&) = delete;
+        AllocationScope(AllocationScope&&) = delete;
+        AllocationScope& operator=(const AllocationScope&) = delete;
+        AllocationScope& operator=(AllocationScope&&) = delete;
+        ~AllocationScope();
+
+        operator bool() const { return true; }
+    };
+
+    template <typename F>
+    auto invokeBenchmarkBody(F& fun, unsigned long long i, int) -> decltype(fun(i)) {
+        return fun(i);
+    }
+
+    template <typename F>
+    auto invokeBenchmarkBody(F& fun, unsigned long long, long) -> decltype(fun()) {
+        return fun();
+    }
+
+    // a value returned by the body of a benchmark is kept from being optimized away
+    template <typename F>
+    auto callBenchmarkBody(F& fun, unsigned long long i, int)
+            -> decltype(do_not_optimize(invokeBenchmarkBody(fun, i, 0)), void()) {
+        do_not_optimize(invokeBenchmarkBody(fun, i, 0));
+    }
+
+    template <typename F>
+    void callBenchmarkBody(F& fun, unsigned long long i, long) {
+        invokeBenchmarkBody(fun, i, 0);
+    }
+
     template <typename L, typename R>
     String stringifyBinaryExpr(const DOCTEST_REF_WRAP(L) lhs, const char* op,
                                const DOCTEST_REF_WRAP(R) rhs) {
@@ -1396,7 +1577,9 @@ DOCTEST_CLANG_SUPPRESS_WARNING_WITH_PUSH("-Wunused-comparison")
         String m_decomp;
 
         Result() = default; // TODO: Why do we need this? (To remove NOLINT)
-        Result(bool passed, const String& decomposition = String());
+        // cppcheck-suppress noExplicitConstructor
+        Result(bool passed);
+        Result(bool passed, const String& decomposition);
 
         // forbidding some expressions based on this table: https://en.cppreference.com/w/cpp/language/operator_precedence
         DOCTEST_FORBIT_EXPRESSION(Result, &)
@@ -1595,6 +1778,7 @@ DOCTEST_CLANG_SUPPRESS_WARNING_POP
         bool        m_no_output = false;
         bool        m_may_fail = false;
         bool        m_should_fail = false;
+        bool        m_parallel_subcases = false;
         int         m_expected_failures = 0;
         double      m_timeout = 0;
 
@@ -1642,10 +1826,21 @@ DOCTEST_CLANG_SUPPRESS_WARNING_POP
         ~TestCase() = default;
     };
 
+    // put in the "doctest_tests" linker section by the macros when DOCTEST_CONFIG_TEST_SECTION is
+    // defined - registers a test case (or starts/ends a test suite block) when the run starts
+    struct TestSectionEntry
+    {
+        int (*reg)();
+        const char* file;
+        unsigned    line;
+    };
+
     // forward declarations of functions used by the macros
     DOCTEST_INTERFACE int  regTest(const TestCase& tc);
     DOCTEST_INTERFACE int  setTestSuite(const TestSuite& ts);
     DOCTEST_INTERFACE bool isDebuggerActive();
+    // repeats the (cached) debugger detection - for when one gets attached in the middle of a run
+    DOCTEST_INTERFACE void redetectDebugger();
 
     template<typename T>
     int instantiationHelper(const T&) { return 0; }
@@ -1684,32 +1879,8 @@ DOCTEST_CLANG_SUPPRESS_WARNING_POP
         ResultBuilder(assertType::Enum at, const char* file, int line, const char* expr,
                       const char* exception_type, const Contains& exception_string);
 
-        void setResult(const Result& res);
-
-        template <int comparison, typename L, typename R>
-        DOCTEST_NOINLINE bool binary_assert(const DOCTEST_REF_WRAP(L) lhs,
-                                            const DOCTEST_REF_WRAP(R) rhs) {
-            m_failed = !RelationalComparator<comparison, L, R>()(lhs, rhs);
-            if (m_failed || getContextOptions()->success) {
-                m_decomp = stringifyBinaryExpr(lhs, ", ", rhs);
-            }
-            return !m_failed;
-        }
-
-        template <typename L>
-        DOCTEST_NOINLINE bool unary_assert(const DOCTEST_REF_WRAP(L) val) {
-            m_failed = !val;
-
-            if (m_at & assertType::is_false) { //!OCLINT bitwise operator in conditional
-                m_failed = !m_failed;
-            }
-
-            if (m_failed || getContextOptions()->success) {
-                m_decomp = (DOCTEST_STRINGIFY(val));
-            }
-
-            return !m_failed;
-        }
+        // a thrown exception is passed as the decomposition of the result
+        void setResult(const Result& res, bool threw = false);
 
         void translateException();
 
@@ -1726,6 +1897,32 @@ DOCTEST_CLANG_SUPPRESS_WARNING_POP
         };
     } // namespace assertAction
 
+    // the comparison part of the asserts - the result is stringified only if it will be reported
+    template <int comparison, typename L, typename R>
+    DOCTEST_NOINLINE Result binary_assert_result(const DOCTEST_REF_WRAP(L) lhs,
+                                                 const DOCTEST_REF_WRAP(R) rhs) {
+        bool passed = RelationalComparator<comparison, L, R>()(lhs, rhs);
+        if(!passed || getContextOptions()->success)
+            return Result(passed, stringifyBinaryExpr(lhs, ", ", rhs));
+        return Result(passed);
+    }
+
+    template <typename L>
+    DOCTEST_NOINLINE Result unary_assert_result(assertType::Enum at, const DOCTEST_REF_WRAP(L) val) {
+        bool passed = !!val;
+        if(at & assertType::is_false) //!OCLINT bitwise operator in conditional
+            passed = !passed;
+        if(!passed || getContextOptions()->success)
+            return Result(passed, (DOCTEST_STRINGIFY(val)));
+        return Result(passed);
+    }
+
+    // the pass path of the asserts - only bumps the assert counter and returns true if nobody has
+    // to see the assert, otherwise returns false and a ResultBuilder has to be constructed for it
+    DOCTEST_INTERFACE bool countPassedAssert(assertType::Enum at);
+
+    DOCTEST_INTERFACE String translateActiveException();
+
     DOCTEST_INTERFACE void failed_out_of_a_testing_context(const AssertData& ad);
 
     DOCTEST_INTERFACE bool decomp_assert(assertType::Enum at, const char* file, int line,
@@ -1749,6 +1946,8 @@ DOCTEST_CLANG_SUPPRESS_WARNING_POP
     } while(false)
 
 #define DOCTEST_ASSERT_IN_TESTS(decomp)                                                            \
+    if(!failed && countPassedAssert(at))                                                           \
+        return true;                                                                               \
     ResultBuilder rb(at, file, line, expr);                                                        \
     rb.m_failed = failed;                                                                          \
     if(rb.m_failed || getContextOptions()->success)                                                \
@@ -1909,6 +2108,48 @@ DOCTEST_MSVC_SUPPRESS_WARNING_POP
     }
 } // namespace detail
 
+// passed to the body of DOCTEST_BENCHMARK_ADVANCED - only the code given to measure() is timed
+class Chronometer
+{
+    detail::Benchmark* m_benchmark;
+
+public:
+    explicit Chronometer(detail::Benchmark& in)
+            : m_benchmark(&in) {}
+
+    // calls the function (optionally with the index of the iteration) for a batch of iterations
+    template <typename F>
+    void measure(F&& fun) {
+        const unsigned long long iterations = m_benchmark->startBatch();
+        for(unsigned long long i = 0; i < iterations; ++i)
+            detail::callBenchmarkBody(fun, i, 0);
+        m_benchmark->endBatch();
+    }
+};
+
+namespace detail {
+    template <typename F>
+    auto runBenchmarkBatch(Benchmark& bench, F& fun, int) -> decltype(fun(Chronometer(bench)), void()) {
+        fun(Chronometer(bench));
+    }
+
+    template <typename F>
+    void runBenchmarkBatch(Benchmark& bench, F& fun, long) {
+        Chronometer(bench).measure(fun);
+    }
+
+    template <typename F>
+    void Benchmark::operator=(F&& fun) { // NOLINT(misc-unconventional-assign-operator)
+        for(;;) {
+            const unsigned long long batches = m_batches;
+            runBenchmarkBatch(*this, fun, 0);
+            // the benchmark is over when the last batch has been measured (or nothing was measured)
+            if(m_batches == batches || m_state == nullptr)
+                break;
+        }
+    }
+} // namespace detail
+
 #define DOCTEST_DEFINE_DECORATOR(name, type, def)                                                  \
     struct name                                                                                    \
     {                                                                                              \
@@ -1928,6 +2169,7 @@ DOCTEST_DEFINE_DECORATOR(timeout, double, 0);
 DOCTEST_DEFINE_DECORATOR(may_fail, bool, true);
 DOCTEST_DEFINE_DECORATOR(should_fail, bool, true);
 DOCTEST_DEFINE_DECORATOR(expected_failures, int, 0);
+DOCTEST_DEFINE_DECORATOR(parallel_subcases, bool, true);
 
 template <typename T>
 int registerExceptionTranslator(String (*translateFunction)(T)) {
@@ -1938,6 +2180,30 @@ int registerExceptionTranslator(String (*translateFunction)(T)) {
     return 0;
 }
 
+namespace detail {
+    // the values of test_cache() for the test case which is running - keyed on the name of their
+    // type (the same in every shared library, unlike the address of a static) and the name given
+    // by the user - they are destroyed in the reverse order of their creation when it ends
+    DOCTEST_INTERFACE void* findTestCacheValue(const String& type, const String& name);
+    DOCTEST_INTERFACE void  addTestCacheValue(const String& type, const String& name, void* value,
+                                              void (*destroy)(void*));
+
+    // true only for the first pass through the test case which is running (see ONCE_PER_TEST)
+    DOCTEST_INTERFACE bool enterOncePerTest(const String& name);
+} // namespace detail
+
+// a value shared by all passes through the test case which is running (every leaf subcase is a
+// separate pass) - created by make() on the first one and destroyed when the test case ends
+template <typename T, typename F>
+T& test_cache(const String& name, F&& make) {
+    const String type = toString<T>();
+    if(void* value = detail::findTestCacheValue(type, name))
+        return *static_cast<T*>(value);
+    T* value = new T(make());
+    detail::addTestCacheValue(type, name, value, [](void* in) { delete static_cast<T*>(in); });
+    return *value;
+}
+
 } // namespace doctest
 
 // in a separate namespace outside of doctest because the DOCTEST_TEST_SUITE macro
@@ -1952,6 +2218,19 @@ template <typename T>
 int registerExceptionTranslator(String (*)(T)) {
     return 0;
 }
+
+// nothing is shared without the test runner - the value is created by every call
+template <typename T, typename F>
+T test_cache(const String&, F&& make) {
+    return make();
+}
+
+class Chronometer
+{
+public:
+    template <typename F>
+    void measure(F&&) {}
+};
 #endif // DOCTEST_CONFIG_DISABLE
 
 namespace detail {
@@ -2019,6 +2298,25 @@ struct DOCTEST_INTERFACE CurrentTestCaseStats
     double seconds;
     int    failure_flags; // use TestCaseFailureReason::Enum
     bool   testCaseSuccess;
+
+    // the heap usage of the thread executing the test case - only if it is tracked (see the
+    // DOCTEST_CONFIG_TRACK_ALLOCATIONS config identifier)
+    bool               allocationsTracked;
+    unsigned long long numAllocations;
+    unsigned long long allocatedBytes;
+    unsigned long long peakAllocatedBytes; // above what had been allocated when it started
+
+    // the resources used by the thread executing the test case - only if they are measured (see
+    // the --resource-summary option)
+    bool               resourcesMeasured;
+    double             userSeconds;            // CPU time spent in user mode
+    double             systemSeconds;          // CPU time spent in the kernel
+    long long          residentBytes;          // the change of the resident set size of the process
+    long long          peakResidentBytes;      // the growth of the peak resident set size
+    unsigned long long majorFaults;            // page faults which required I/O
+    unsigned long long minorFaults;            // page faults served without I/O
+    unsigned long long voluntarySwitches;      // the thread blocked
+    unsigned long long involuntarySwitches;    // the thread was preempted
 };
 
 struct DOCTEST_INTERFACE TestCaseException
@@ -2078,6 +2376,20 @@ struct DOCTEST_INTERFACE IReporter
     // called for each message (don't cache pointers to the input)
     virtual void log_message(const MessageData&) = 0;
 
+    // called once before the test run to ask if log_assert() should be called for passing asserts
+    // as well - the default is yes, reporters which ignore them can speed up the runs by saying no
+    virtual bool wants_successful_asserts() const { return true; }
+
+    // called when a benchmark has finished measuring (don't cache pointers to the input)
+    // not pure virtual so existing reporters don't have to implement it
+    virtual void benchmark_end(const BenchmarkStats&) {}
+
+    // called with the performance counters of a test case (before test_case_end()), a subcase
+    // (before subcase_end()) or a benchmark (after benchmark_end()) when they are measured (see the
+    // --perf-counters option) - don't cache pointers to the input
+    // not pure virtual so existing reporters don't have to implement it
+    virtual void perf_counters(const PerfCounterStats&) {}
+
     // called when a test case is skipped either because it doesn't pass the filters, has a skip decorator
     // or isn't in the execution range (between first and last) (safe to cache a pointer to the input)
     virtual void test_case_skipped(const TestCaseData&) = 0;
@@ -2136,15 +2448,40 @@ int registerReporter(const char* name, int priority, bool isReporter) {
     b.react();                                                                                     \
     DOCTEST_FUNC_SCOPE_RET(!b.m_failed)
 
+// binding to a reference picks Expression_lhs::operator Result() instead of operator L()
+#define DOCTEST_EVALUATE_RESULT(...)                                                               \
+    {                                                                                              \
+        doctest::detail::Result&& DOCTEST_EVALUATED = __VA_ARGS__;                                 \
+        DOCTEST_RES = static_cast<doctest::detail::Result&&>(DOCTEST_EVALUATED);                   \
+    }
+
 #ifdef DOCTEST_CONFIG_NO_TRY_CATCH_IN_ASSERTS
-#define DOCTEST_WRAP_IN_TRY(x) x;
+#define DOCTEST_EVALUATE_IN_TRY(...) DOCTEST_EVALUATE_RESULT(__VA_ARGS__)
 #else // DOCTEST_CONFIG_NO_TRY_CATCH_IN_ASSERTS
-#define DOCTEST_WRAP_IN_TRY(x)                                                                     \
+#define DOCTEST_EVALUATE_IN_TRY(...)                                                               \
     try {                                                                                          \
-        x;                                                                                         \
-    } catch(...) { DOCTEST_RB.translateException(); }
+        DOCTEST_EVALUATE_RESULT(__VA_ARGS__)                                                       \
+    } catch(...) {                                                                                 \
+        DOCTEST_RES.m_decomp = doctest::detail::translateActiveException();                        \
+        DOCTEST_THREW        = true;                                                               \
+    }
 #endif // DOCTEST_CONFIG_NO_TRY_CATCH_IN_ASSERTS
 
+// the expression is evaluated first and a ResultBuilder is constructed only if the assert failed,
+// threw or has to be reported - a passing assert costs just the comparison and a counter bump
+#define DOCTEST_ASSERT_EVALUATE(assert_type, expr, ...)                                            \
+    doctest::detail::Result DOCTEST_RES;                                                           \
+    bool                    DOCTEST_THREW = false;                                                 \
+    DOCTEST_EVALUATE_IN_TRY(__VA_ARGS__)                                                           \
+    if(DOCTEST_THREW || !DOCTEST_RES.m_passed ||                                                   \
+       !doctest::detail::countPassedAssert(doctest::assertType::assert_type)) {                    \
+        doctest::detail::ResultBuilder DOCTEST_RB(doctest::assertType::assert_type, __FILE__,      \
+                                                   __LINE__, expr);                                \
+        DOCTEST_RB.setResult(DOCTEST_RES, DOCTEST_THREW);                                          \
+        DOCTEST_ASSERT_LOG_REACT_RETURN(DOCTEST_RB);                                               \
+    }                                                                                              \
+    DOCTEST_FUNC_SCOPE_RET(true)
+
 #ifdef DOCTEST_CONFIG_VOID_CAST_EXPRESSIONS
 #define DOCTEST_CAST_TO_VOID(...)                                                                  \
     DOCTEST_GCC_SUPPRESS_WARNING_WITH_PUSH("-Wuseless-cast")                                       \
@@ -2163,6 +2500,38 @@ int registerReporter(const char* name, int priority, bool isReporter) {
                             doctest_detail_test_suite_ns::getCurrentTestSuite()) *                 \
                     decorators))
 
+#ifdef DOCTEST_CONFIG_TEST_SECTION
+// a constant initialized entry instead of a dynamic initializer - Context::run() calls the
+// registration functions of all entries (sorted by file and line). Only pointers go in the section
+// because the compiler might pad bigger objects and then they can't be walked as an array
+#define DOCTEST_TEST_SECTION_ENTRY(reg)                                                            \
+    static const doctest::detail::TestSectionEntry DOCTEST_CAT(reg, _ENTRY) = {reg, __FILE__,      \
+                                                                               __LINE__};          \
+    __attribute__((used, section("doctest_tests"))) static const doctest::detail::TestSectionEntry* \
+            const DOCTEST_CAT(reg, _ENTRY_PTR) = &DOCTEST_CAT(reg, _ENTRY);
+
+// registers a static function
+#define DOCTEST_REGISTER_STATIC_FUNCTION(f, decorators)                                            \
+    static int DOCTEST_CAT(f, _REG)() {                                                            \
+        return doctest::detail::regTest(                                                           \
+                doctest::detail::TestCase(f, __FILE__, __LINE__,                                   \
+                                          doctest_detail_test_suite_ns::getCurrentTestSuite()) *   \
+                decorators);                                                                       \
+    }                                                                                              \
+    DOCTEST_TEST_SECTION_ENTRY(DOCTEST_CAT(f, _REG))
+
+#define DOCTEST_SET_TEST_SUITE(anon, decorators)                                                   \
+    static int anon() { return doctest::detail::setTestSuite(doctest::detail::TestSuite() * decorators); } \
+    DOCTEST_TEST_SECTION_ENTRY(anon)
+#else // DOCTEST_CONFIG_TEST_SECTION
+#define DOCTEST_REGISTER_STATIC_FUNCTION(f, decorators)                                            \
+    DOCTEST_REGISTER_FUNCTION(DOCTEST_EMPTY, f, decorators)
+
+#define DOCTEST_SET_TEST_SUITE(anon, decorators)                                                   \
+    DOCTEST_GLOBAL_NO_WARNINGS(anon, /* NOLINT(cert-err58-cpp) */                                  \
+            doctest::detail::setTestSuite(doctest::detail::TestSuite() * decorators))
+#endif // DOCTEST_CONFIG_TEST_SECTION
+
 #define DOCTEST_IMPLEMENT_FIXTURE(der, base, func, decorators)                                     \
     namespace { /* NOLINT */                                                                       \
         struct der : public base                                                                   \
@@ -2173,13 +2542,13 @@ int registerReporter(const char* name, int priority, bool isReporter) {
             der v;                                                                                 \
             v.f();                                                                                 \
         }                                                                                          \
-        DOCTEST_REGISTER_FUNCTION(DOCTEST_EMPTY, func, decorators)                                 \
+        DOCTEST_REGISTER_STATIC_FUNCTION(func, decorators)                                         \
     }                                                                                              \
     DOCTEST_INLINE_NOINLINE void der::f() // NOLINT(misc-definitions-in-headers)
 
 #define DOCTEST_CREATE_AND_REGISTER_FUNCTION(f, decorators)                                        \
     static void f();                                                                               \
-    DOCTEST_REGISTER_FUNCTION(DOCTEST_EMPTY, f, decorators)                                        \
+    DOCTEST_REGISTER_STATIC_FUNCTION(f, decorators)                                                \
     static void f()
 
 #define DOCTEST_CREATE_AND_REGISTER_FUNCTION_IN_CLASS(f, proxy, decorators)                        \
@@ -2277,6 +2646,21 @@ int registerReporter(const char* name, int priority, bool isReporter) {
     if(const doctest::detail::Subcase & DOCTEST_ANONYMOUS(DOCTEST_ANON_SUBCASE_) DOCTEST_UNUSED =  \
                doctest::detail::Subcase(name, __FILE__, __LINE__))
 
+// for code which should be executed only on the first pass through a test case with subcases
+#define DOCTEST_ONCE_PER_TEST(name) if(doctest::detail::enterOncePerTest(name))
+
+// for blocks of code which shouldn't allocate more than this
+#define DOCTEST_CHECK_ALLOCATIONS_AT_MOST(max)                                                     \
+    if(const doctest::detail::AllocationScope & DOCTEST_ANONYMOUS(DOCTEST_ANON_ALLOCATIONS_)       \
+               DOCTEST_UNUSED = doctest::detail::AllocationScope(__FILE__, __LINE__,              \
+                                                                 "allocations <= " #max, max))
+#define DOCTEST_CHECK_NO_ALLOC DOCTEST_CHECK_ALLOCATIONS_AT_MOST(0)
+
+// for benchmarks
+#define DOCTEST_BENCHMARK(name) doctest::detail::Benchmark(name, __FILE__, __LINE__) = [&]()
+#define DOCTEST_BENCHMARK_ADVANCED(name)                                                           \
+    doctest::detail::Benchmark(name, __FILE__, __LINE__) = [&]
+
 // for grouping tests in test suites by using code blocks
 #define DOCTEST_TEST_SUITE_IMPL(decorators, ns_name)                                               \
     namespace ns_name { namespace doctest_detail_test_suite_ns {                                   \
@@ -2304,14 +2688,12 @@ int registerReporter(const char* name, int priority, bool isReporter) {
 
 // for starting a testsuite block
 #define DOCTEST_TEST_SUITE_BEGIN(decorators)                                                       \
-    DOCTEST_GLOBAL_NO_WARNINGS(DOCTEST_ANONYMOUS(DOCTEST_ANON_VAR_), /* NOLINT(cert-err58-cpp) */  \
-            doctest::detail::setTestSuite(doctest::detail::TestSuite() * decorators))              \
+    DOCTEST_SET_TEST_SUITE(DOCTEST_ANONYMOUS(DOCTEST_ANON_VAR_), decorators)                       \
     static_assert(true, "")
 
 // for ending a testsuite block
 #define DOCTEST_TEST_SUITE_END                                                                     \
-    DOCTEST_GLOBAL_NO_WARNINGS(DOCTEST_ANONYMOUS(DOCTEST_ANON_VAR_), /* NOLINT(cert-err58-cpp) */  \
-            doctest::detail::setTestSuite(doctest::detail::TestSuite() * ""))                      \
+    DOCTEST_SET_TEST_SUITE(DOCTEST_ANONYMOUS(DOCTEST_ANON_VAR_), "")                               \
     using DOCTEST_ANONYMOUS(DOCTEST_ANON_FOR_SEMICOLON_) = int
 
 // for registering exception translators
@@ -2381,12 +2763,9 @@ int registerReporter(const char* name, int priority, bool isReporter) {
 #define DOCTEST_ASSERT_IMPLEMENT_2(assert_type, ...)                                               \
     DOCTEST_CLANG_SUPPRESS_WARNING_WITH_PUSH("-Woverloaded-shift-op-parentheses")                  \
     /* NOLINTNEXTLINE(clang-analyzer-cplusplus.NewDeleteLeaks) */                                  \
-    doctest::detail::ResultBuilder DOCTEST_RB(doctest::assertType::assert_type, __FILE__,          \
-                                               __LINE__, #__VA_ARGS__);                            \
-    DOCTEST_WRAP_IN_TRY(DOCTEST_RB.setResult(                                                      \
+    DOCTEST_ASSERT_EVALUATE(assert_type, #__VA_ARGS__,                                             \
             doctest::detail::ExpressionDecomposer(doctest::assertType::assert_type)                \
-            << __VA_ARGS__)) /* NOLINTNEXTLINE(clang-analyzer-cplusplus.NewDeleteLeaks) */         \
-    DOCTEST_ASSERT_LOG_REACT_RETURN(DOCTEST_RB)                                                    \
+            << __VA_ARGS__) /* NOLINT(clang-analyzer-cplusplus.NewDeleteLeaks) */                  \
     DOCTEST_CLANG_SUPPRESS_WARNING_POP
 
 #define DOCTEST_ASSERT_IMPLEMENT_1(assert_type, ...)                                               \
@@ -2396,20 +2775,16 @@ int registerReporter(const char* name, int priority, bool isReporter) {
 
 #define DOCTEST_BINARY_ASSERT(assert_type, comp, ...)                                              \
     DOCTEST_FUNC_SCOPE_BEGIN {                                                                     \
-        doctest::detail::ResultBuilder DOCTEST_RB(doctest::assertType::assert_type, __FILE__,      \
-                                                   __LINE__, #__VA_ARGS__);                        \
-        DOCTEST_WRAP_IN_TRY(                                                                       \
-                DOCTEST_RB.binary_assert<doctest::detail::binaryAssertComparison::comp>(           \
-                        __VA_ARGS__))                                                              \
-        DOCTEST_ASSERT_LOG_REACT_RETURN(DOCTEST_RB);                                               \
+        DOCTEST_ASSERT_EVALUATE(assert_type, #__VA_ARGS__,                                         \
+                doctest::detail::binary_assert_result<                                             \
+                        doctest::detail::binaryAssertComparison::comp>(__VA_ARGS__));              \
     } DOCTEST_FUNC_SCOPE_END
 
 #define DOCTEST_UNARY_ASSERT(assert_type, ...)                                                     \
     DOCTEST_FUNC_SCOPE_BEGIN {                                                                     \
-        doctest::detail::ResultBuilder DOCTEST_RB(doctest::assertType::assert_type, __FILE__,      \
-                                                   __LINE__, #__VA_ARGS__);                        \
-        DOCTEST_WRAP_IN_TRY(DOCTEST_RB.unary_assert(__VA_ARGS__))                                  \
-        DOCTEST_ASSERT_LOG_REACT_RETURN(DOCTEST_RB);                                               \
+        DOCTEST_ASSERT_EVALUATE(assert_type, #__VA_ARGS__,                                         \
+                doctest::detail::unary_assert_result(doctest::assertType::assert_type,             \
+                                                     __VA_ARGS__));                                \
     } DOCTEST_FUNC_SCOPE_END
 
 #else // DOCTEST_CONFIG_SUPER_FAST_ASSERTS
@@ -2610,6 +2985,16 @@ int registerReporter(const char* name, int priority, bool isReporter) {
 
 // for subcases
 #define DOCTEST_SUBCASE(name)
+#define DOCTEST_ONCE_PER_TEST(name)
+
+// for blocks of code which shouldn't allocate
+#define DOCTEST_CHECK_ALLOCATIONS_AT_MOST(max)
+#define DOCTEST_CHECK_NO_ALLOC
+
+// for benchmarks
+#define DOCTEST_BENCHMARK(name) auto DOCTEST_ANONYMOUS(DOCTEST_ANON_BENCHMARK_) DOCTEST_UNUSED = [&]()
+#define DOCTEST_BENCHMARK_ADVANCED(name)                                                           \
+    auto DOCTEST_ANONYMOUS(DOCTEST_ANON_BENCHMARK_) DOCTEST_UNUSED = [&]
 
 // for a testsuite block
 #define DOCTEST_TEST_SUITE(name) namespace // NOLINT
@@ -2941,6 +3326,11 @@ namespace detail {
 #define TEST_CASE_TEMPLATE_INVOKE(id, ...) DOCTEST_TEST_CASE_TEMPLATE_INVOKE(id, __VA_ARGS__)
 #define TEST_CASE_TEMPLATE_APPLY(id, ...) DOCTEST_TEST_CASE_TEMPLATE_APPLY(id, __VA_ARGS__)
 #define SUBCASE(name) DOCTEST_SUBCASE(name)
+#define ONCE_PER_TEST(name) DOCTEST_ONCE_PER_TEST(name)
+#define CHECK_ALLOCATIONS_AT_MOST(max) DOCTEST_CHECK_ALLOCATIONS_AT_MOST(max)
+#define CHECK_NO_ALLOC DOCTEST_CHECK_NO_ALLOC
+#define BENCHMARK(name) DOCTEST_BENCHMARK(name)
+#define BENCHMARK_ADVANCED(name) DOCTEST_BENCHMARK_ADVANCED(name)
 #define TEST_SUITE(decorators) DOCTEST_TEST_SUITE(decorators)
 #define TEST_SUITE_BEGIN(name) DOCTEST_TEST_SUITE_BEGIN(name)
 #define TEST_SUITE_END DOCTEST_TEST_SUITE_END
@@ -3069,8 +3459,10 @@ namespace detail {
 
 #ifndef DOCTEST_CONFIG_DISABLE
 
-// this is here to clear the 'current test suite' for the current translation unit - at the top
-DOCTEST_TEST_SUITE_END();
+// this is here to clear the 'current test suite' for the current translation unit - at the top.
+// Always a dynamic initializer because not all test cases go in the test section
+DOCTEST_GLOBAL_NO_WARNINGS(DOCTEST_ANONYMOUS(DOCTEST_ANON_VAR_), /* NOLINT(cert-err58-cpp) */
+                           doctest::detail::setTestSuite(doctest::detail::TestSuite() * ""))
 
 #endif // DOCTEST_CONFIG_DISABLE
 
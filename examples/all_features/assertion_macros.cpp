@@ -6,6 +6,8 @@
 DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
 #include <stdexcept>
 #include <cmath>
+#include <memory>
+#include <vector>
 DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
 
 TEST_CASE("normal macros") {
@@ -233,3 +235,30 @@ TEST_CASE("check return values no print") {
     if (CHECK_THROWS_WITH(throw_if(true, 2), "1")) { MESSAGE(":D"); }
 }
 DOCTEST_MSVC_SUPPRESS_WARNING_POP
+
+TEST_CASE("allocation scopes") {
+    CHECK_NO_ALLOC {
+        int values[4] = {1, 2, 3, 4};
+        int sum       = values[0] + values[1] + values[2] + values[3];
+        (void)sum;
+    }
+    CHECK_ALLOCATIONS_AT_MOST(1) {
+        std::unique_ptr<int> p(new int(5));
+    }
+    // fails only when built with DOCTEST_CONFIG_TRACK_ALLOCATIONS
+    CHECK_NO_ALLOC {
+        std::unique_ptr<int> p(new int(5));
+    }
+    // exactly 3 allocations - only the second scope fails when they are counted
+    auto allocate = []() {
+        std::unique_ptr<int>   single(new int(1));
+        std::unique_ptr<int[]> array(new int[4]);
+        std::vector<char>      buffer(100);
+    };
+    CHECK_ALLOCATIONS_AT_MOST(3) {
+        allocate();
+    }
+    CHECK_ALLOCATIONS_AT_MOST(2) {
+        allocate();
+    }
+}
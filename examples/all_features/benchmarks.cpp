@@ -0,0 +1,48 @@
+#include <doctest/doctest.h>
+
+#include "header.h"
+
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
+#include <numeric>
+#include <vector>
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
+
+static unsigned fibonacci(unsigned n) {
+    unsigned prev = 0;
+    unsigned curr = 1;
+    for(unsigned i = 0; i < n; ++i) {
+        const unsigned next = prev + curr;
+        prev                = curr;
+        curr                = next;
+    }
+    return prev;
+}
+
+TEST_CASE("benchmarks") {
+    BENCHMARK("fibonacci 15") {
+        unsigned n = 15;
+        doctest::do_not_optimize(n);
+        unsigned res = fibonacci(n);
+        doctest::do_not_optimize(res);
+    };
+
+    // the returned value is kept from being optimized away
+    BENCHMARK("fibonacci 10") { return fibonacci(10); };
+
+    SUBCASE("in a subcase") {
+        std::vector<int> vec(100);
+        std::iota(vec.begin(), vec.end(), 0);
+
+        // the setup of each batch isn't measured
+        BENCHMARK_ADVANCED("summing a vector")(doctest::Chronometer meter) {
+            std::vector<int> copy = vec;
+            meter.measure([&](unsigned long long i) {
+                copy[i % copy.size()] += 1;
+                int sum = std::accumulate(copy.begin(), copy.end(), 0);
+                doctest::do_not_optimize(sum);
+            });
+        };
+
+        CHECK(vec.size() == 100);
+    }
+}
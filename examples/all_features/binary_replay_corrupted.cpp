@@ -0,0 +1,119 @@
+#define DOCTEST_CONFIG_IMPLEMENT
+#include <doctest/doctest.h>
+
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
+
+TEST_CASE("recorded") {
+    INFO("a context");
+    SUBCASE("a subcase") {
+        CHECK(1 == 2);
+        MESSAGE("a message");
+    }
+    SUBCASE("another subcase") {
+        CHECK(true);
+    }
+}
+
+TEST_CASE("recorded too") {
+    CHECK_EQ(1, 1);
+}
+
+static const char* const recording = "binary_replay_corrupted.bin";
+static const char* const corrupted = "binary_replay_corrupted_copy.bin";
+
+static void write(const std::string& data) {
+    std::ofstream out(corrupted, std::ios::binary);
+    out.write(data.data(), std::streamsize(data.size()));
+}
+
+static int replay(int argc, char** argv, const char* reporter, const char* out = nullptr) {
+    doctest::Context context(argc, argv);
+    context.setOption("replay", corrupted);
+    context.setOption("reporters", reporter);
+    context.setOption("no-exitcode", false); // a corrupted recording fails the replay
+    if(out)
+        context.setOption("out", out);
+    return context.run();
+}
+
+static void setUnsigned(std::string& data, size_t pos, unsigned value) {
+    std::memcpy(&data[pos], &value, sizeof(value));
+}
+
+// the replay of a recording of the binary reporter which has been tampered with stops at the first
+// malformed message with a diagnostic instead of crashing
+int main(int argc, char** argv) {
+    {
+        doctest::Context context(argc, argv);
+        context.setOption("reporters", "binary");
+        context.setOption("out", recording);
+        context.setOption("success", true);
+        context.run();
+    }
+
+    std::ifstream in(recording, std::ios::binary);
+    const std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    // the stream starts with a line of text followed by the messages: the size of a message and
+    // then its type (a byte), the number of its contexts and its fields - the first message is the
+    // start of the test run and the second one the start of the first test case
+    const size_t first  = data.find('\n') + 1;
+    const size_t second = first + sizeof(unsigned) + 1 + sizeof(unsigned);
+    const size_t type   = second + sizeof(unsigned);
+    const size_t count  = type + 1;
+    const size_t file   = count + sizeof(unsigned);
+
+    struct
+    {
+        const char* what;
+        size_t      pos;
+        unsigned    value;
+        bool        byte;
+    } const cases[] = {
+            {"a message without a size", second, 0, false},
+            {"an unknown type of event", type, 0x7f, true},
+            {"the end of a subcase which hasn't started", type, 7, true},
+            {"more contexts than there are bytes", count, 0x7fffffff, false},
+            {"a string longer than the message", file, 0xfffffff0, false},
+    };
+
+    for(const auto& curr : cases) {
+        std::string copy = data;
+        if(curr.byte)
+            copy[curr.pos] = char(curr.value);
+        else
+            setUnsigned(copy, curr.pos, curr.value);
+        write(copy);
+        std::cout << "=== " << curr.what << std::endl;
+        const int res = replay(argc, argv, "console");
+        std::cout << "exit code: " << res << std::endl;
+    }
+
+    // random bytes all over the recording - the reporters write to a file and the diagnostics go
+    // to another one since where the replays stop depends on the paths in the recording
+    if(!std::freopen("binary_replay_corrupted_errors.txt", "w", stderr))
+        return 1;
+    const char* const reporters[] = {"console", "xml", "junit"};
+    const unsigned    copies      = 300;
+    unsigned          state       = 12345;
+    for(unsigned i = 0; i < copies; ++i) {
+        std::string copy = data;
+        for(int k = 0; k < 4; ++k) {
+            state          = state * 1103515245 + 12345;
+            const auto pos = first + (state >> 8) % (copy.size() - first);
+            state          = state * 1103515245 + 12345;
+            copy[pos]      = char(state >> 16);
+        }
+        write(copy);
+        replay(argc, argv, reporters[i % 3], "binary_replay_corrupted_output.txt");
+    }
+    std::cout << "=== replayed " << copies << " copies with random bytes" << std::endl;
+    return 0;
+}
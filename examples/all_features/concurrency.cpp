@@ -4,9 +4,14 @@
 
 DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
 #include <thread>
+#include <atomic>
+#include <chrono>
+#include <ostream>
+#include <cstdlib>
 #include <mutex>
 #include <exception>
 #include <stdexcept>
+#include <string>
 DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
 
 DOCTEST_MSVC_SUPPRESS_WARNING(4626) // assignment operator was implicitly defined as deleted
@@ -68,4 +73,98 @@ TEST_CASE("threads...") {
     }
 }
 
+// with --thread-logs the asserts of the spawned threads are reported together when the subcase
+// ends - after the ones of the test runner thread and with the output of every thread kept together
+TEST_CASE("asserts of spawned threads logged until the subcase ends") {
+    auto call_from_thread = []() {
+        INFO("spawned thread");
+        for(int i = 0; i < 3; ++i) {
+            CAPTURE(i);
+            CHECK(i < 2);
+        }
+        WARN(false);
+    };
+
+    SUBCASE("spawned threads") {
+        std::thread t1(call_from_thread);
+        std::thread t2(call_from_thread);
+        std::thread t3(call_from_thread);
+
+        t1.join();
+        t2.join();
+        t3.join();
+
+        CHECK_MESSAGE(false, "from the test runner thread");
+    }
+}
+
+// with --parallel the asserts of a spawned thread are reported for the test case which has started
+// it - even when another one which spawns threads is executed at the same time
+static void assert_on_spawned_thread(int value) {
+    std::thread t([value]() {
+        CAPTURE(value);
+        CHECK(value == 0);
+    });
+    t.join();
+}
+
+TEST_CASE("spawned thread of a test case executed in parallel") {
+    assert_on_spawned_thread(1);
+}
+
+TEST_CASE("spawned thread of another test case executed in parallel") {
+    assert_on_spawned_thread(2);
+}
+
+// the asserts of a thread started by a subcase are reported for the pass through it
+TEST_CASE("subcases traversed in parallel which start threads" * doctest::parallel_subcases()) {
+    for(int i = 0; i < 3; ++i) {
+        SUBCASE(("subcase " + std::to_string(i)).c_str()) {
+            assert_on_spawned_thread(i);
+        }
+    }
+}
+
+// skipped unless --no-skip is used - see the watchdog tests in CMakeLists.txt
+TEST_CASE("hangs until stopped by the watchdog" * doctest::skip() * doctest::timeout(0.2)) {
+    MESSAGE("hanging...");
+    // the watchdog stops it long before this ends
+    for(int i = 0; i < 3000; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+}
+
+TEST_CASE("runs after the one stopped by the watchdog" * doctest::skip()) {
+    CHECK(1 == 1);
+}
+
+// skipped unless --no-skip is used - see the isolated test in CMakeLists.txt
+TEST_CASE("exits in the middle of the test case" * doctest::skip()) {
+    CHECK(1 == 1);
+    std::_Exit(3);
+}
+
+TEST_CASE("runs after the one which has exited" * doctest::skip()) {
+    CHECK(1 == 1);
+}
+
+static std::atomic<int> g_numStringified(0);
+
+struct CountedContext
+{};
+
+static std::ostream& operator<<(std::ostream& s, const CountedContext&) {
+    ++g_numStringified;
+    return s << "counted";
+}
+
+// skipped unless --no-skip is used - see the contexts tests in CMakeLists.txt
+TEST_CASE("stringifies the contexts only of the events which get reported" * doctest::skip()) {
+    CountedContext context;
+    INFO(context);
+    CHECK(1 == 1);
+    CHECK(2 == 2);
+    MESSAGE("the message is reported with its context");
+    CHECK(g_numStringified.load() == 1);
+}
+
 #endif // DOCTEST_CONFIG_NO_EXCEPTIONS
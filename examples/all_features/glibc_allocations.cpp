@@ -0,0 +1,68 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#define DOCTEST_CONFIG_TRACK_ALLOCATIONS
+#include <doctest/doctest.h>
+
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <malloc.h>
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
+
+DOCTEST_CLANG_SUPPRESS_WARNING("-Wweak-vtables")
+
+static unsigned long long g_numAllocations     = 0;
+static unsigned long long g_peakAllocatedBytes = 0;
+
+// keeps the heap usage of the last test case which has ended
+struct AllocationsListener : public doctest::IReporter
+{
+    AllocationsListener(const doctest::ContextOptions&) {}
+
+    void report_query(const doctest::QueryData&) override {}
+    void test_run_start() override {}
+    void test_run_end(const doctest::TestRunStats&) override {}
+    void test_case_start(const doctest::TestCaseData&) override {}
+    void test_case_reenter(const doctest::TestCaseData&) override {}
+    void test_case_end(const doctest::CurrentTestCaseStats& in) override {
+        g_numAllocations     = in.numAllocations;
+        g_peakAllocatedBytes = in.peakAllocatedBytes;
+    }
+    void test_case_exception(const doctest::TestCaseException&) override {}
+    void subcase_start(const doctest::SubcaseSignature&) override {}
+    void subcase_end() override {}
+    void log_assert(const doctest::AssertData&) override {}
+    void log_message(const doctest::MessageData&) override {}
+    void test_case_skipped(const doctest::TestCaseData&) override {}
+};
+
+REGISTER_LISTENER("allocations", 1, AllocationsListener);
+
+static const size_t pageSize = 4096;
+
+// the blocks of the glibc specific allocation functions are freed with free() like the others
+TEST_CASE("blocks of the whole malloc family") {
+    for(int i = 0; i < 4; ++i) {
+        void* const blocks[] = {valloc(pageSize), pvalloc(pageSize),
+                                reallocarray(nullptr, pageSize, 1),
+                                aligned_alloc(pageSize, pageSize)};
+        for(void* curr : blocks)
+            std::free(curr);
+    }
+}
+
+TEST_CASE("blocks of the whole malloc family - counted") {
+    CHECK(g_numAllocations >= 16);
+    // a block freed after it hasn't been counted would make the heap usage drift below zero
+    CHECK(g_peakAllocatedBytes >= pageSize);
+}
+
+TEST_CASE("arrays too large for the address space") {
+    volatile size_t num = SIZE_MAX / 2;
+    errno               = 0;
+    CHECK(std::calloc(num, 4) == nullptr);
+    CHECK(errno == ENOMEM);
+    errno = 0;
+    CHECK(reallocarray(nullptr, num, 4) == nullptr);
+    CHECK(errno == ENOMEM);
+}
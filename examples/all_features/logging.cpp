@@ -51,6 +51,19 @@ TEST_CASE("a test case that will end from an exception and should print the unpr
     throw_if(true, 0);
 }
 
+static void nestContexts(int depth) {
+    INFO("depth: ", depth);
+    if(depth < 100)
+        nestContexts(depth + 1);
+    else
+        CHECK(doctest::IReporter::get_num_active_contexts() == 101);
+}
+
+TEST_CASE("more nested contexts than fit in the fixed storage of a thread") {
+    nestContexts(0);
+    CHECK(doctest::IReporter::get_num_active_contexts() == 0);
+}
+
 // TODO: Also remove
 // NOLINTNEXTLINE(misc-unused-parameters)
 static void thirdPartyAssert(bool result, bool is_fatal, const char* file, int line) {
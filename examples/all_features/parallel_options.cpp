@@ -0,0 +1,67 @@
+#define DOCTEST_CONFIG_IMPLEMENT
+#include <doctest/doctest.h>
+
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
+#include <iostream>
+#include <sstream>
+#include <string>
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
+
+static const char* const recording = "parallel_options.bin";
+
+// the test cases of coverage_maxout.cpp with all the passing asserts - one of them changes the
+// options which decide how its asserts are printed while it runs
+static void setOptions(doctest::Context& context, int parallel, bool isolate) {
+    context.addFilter("source-file", "*coverage_maxout.cpp");
+    context.setOption("success", true);
+    context.setOption("parallel", parallel);
+    context.setOption("isolate", isolate);
+}
+
+static std::string run(int argc, char** argv, int parallel, bool isolate, const char* replay = "") {
+    std::ostringstream out;
+    doctest::Context   context(argc, argv);
+    setOptions(context, parallel, isolate);
+    context.setOption("replay", replay);
+    context.setCout(&out);
+    context.run();
+    return out.str();
+}
+
+// the events recorded by the workers are reported with the options the test code had set when
+// they happened - the output has to be the same as for a serial run (it has absolute paths so it's
+// printed only when it differs)
+int main(int argc, char** argv) {
+    const std::string serial = run(argc, argv, 1, false);
+
+    {
+        doctest::Context context(argc, argv);
+        setOptions(context, 1, false);
+        context.setOption("reporters", "binary");
+        context.setOption("out", recording);
+        context.run();
+    }
+
+    struct
+    {
+        const char* what;
+        std::string output;
+    } const cases[] = {
+            {"--parallel=2", run(argc, argv, 2, false)},
+            {"--parallel=2 --isolate", run(argc, argv, 2, true)},
+            {"--replay of the binary reporter", run(argc, argv, 1, false, recording)},
+    };
+
+    int res = 0;
+    for(const auto& curr : cases) {
+        if(curr.output == serial) {
+            std::cout << "=== " << curr.what << ": the same output as a serial run" << std::endl;
+            continue;
+        }
+        std::cout << "=== " << curr.what << ":\n"
+                  << curr.output << "=== instead of:\n"
+                  << serial << std::endl;
+        res = 1;
+    }
+    return res;
+}
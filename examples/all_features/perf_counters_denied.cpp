@@ -0,0 +1,83 @@
+#define DOCTEST_CONFIG_IMPLEMENT
+#include <doctest/doctest.h>
+
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <linux/filter.h>
+#include <linux/seccomp.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
+
+DOCTEST_CLANG_SUPPRESS_WARNING("-Wweak-vtables")
+DOCTEST_CLANG_SUPPRESS_WARNING("-Wold-style-cast")
+DOCTEST_GCC_SUPPRESS_WARNING("-Wold-style-cast")
+DOCTEST_GCC_SUPPRESS_WARNING("-Wuseless-cast")
+
+// the perf_event_open() calls of the process fail with the given errno - as they do with a strict
+// perf_event_paranoid (EACCES) or on a kernel/VM without any of the counters (ENOENT)
+static bool denyPerfEventOpen(unsigned error) {
+    sock_filter filter[] = {
+            BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(seccomp_data, nr)),
+            BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, __NR_perf_event_open, 0, 1),
+            BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ERRNO | (error & SECCOMP_RET_DATA)),
+            BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW)};
+    sock_fprog program = {static_cast<unsigned short>(sizeof(filter) / sizeof(filter[0])), filter};
+    return prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) == 0 &&
+           prctl(PR_SET_SECCOMP, SECCOMP_MODE_FILTER, &program) == 0;
+}
+
+static std::atomic<int> g_reported(0);
+
+// counts the performance counters which get reported - none of them can be read
+struct PerfCountersListener : public doctest::IReporter
+{
+    PerfCountersListener(const doctest::ContextOptions&) {}
+
+    void report_query(const doctest::QueryData&) override {}
+    void test_run_start() override {}
+    void test_run_end(const doctest::TestRunStats&) override {}
+    void test_case_start(const doctest::TestCaseData&) override {}
+    void test_case_reenter(const doctest::TestCaseData&) override {}
+    void test_case_end(const doctest::CurrentTestCaseStats&) override {}
+    void test_case_exception(const doctest::TestCaseException&) override {}
+    void subcase_start(const doctest::SubcaseSignature&) override {}
+    void subcase_end() override {}
+    void log_assert(const doctest::AssertData&) override {}
+    void log_message(const doctest::MessageData&) override {}
+    void perf_counters(const doctest::PerfCounterStats&) override { ++g_reported; }
+    void test_case_skipped(const doctest::TestCaseData&) override {}
+};
+
+REGISTER_LISTENER("perf_counters", 1, PerfCountersListener);
+
+TEST_CASE("perf counters which can't be opened") {
+    SUBCASE("a subcase with a benchmark") {
+        BENCHMARK("an empty loop") {
+            int i = 0;
+            doctest::do_not_optimize(i);
+        };
+    }
+    CHECK(g_reported == 0);
+}
+
+TEST_CASE("perf counters which can't be opened - after the previous test case") {
+    CHECK(g_reported == 0);
+}
+
+int main(int argc, char** argv) {
+    unsigned error = EACCES;
+    for(int i = 1; i < argc; ++i)
+        if(std::strcmp(argv[i], "--enoent") == 0)
+            error = ENOENT;
+
+    if(!denyPerfEventOpen(error))
+        std::cout << "perf_event_open() couldn't be denied with a seccomp filter" << std::endl;
+
+    doctest::Context context(argc, argv);
+    return context.run();
+}
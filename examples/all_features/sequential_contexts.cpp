@@ -0,0 +1,34 @@
+#define DOCTEST_CONFIG_IMPLEMENT
+#include <doctest/doctest.h>
+
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_BEGIN
+#include <iostream>
+DOCTEST_MAKE_STD_HEADERS_CLEAN_FROM_WARNINGS_ON_WALL_END
+
+TEST_CASE("asserts of the first test run") {
+    CHECK(1 == 2);
+    CHECK(true);
+    CHECK(true);
+}
+
+TEST_CASE("asserts of the second test run") {
+    CHECK(true);
+    CHECK(true);
+    CHECK(true);
+}
+
+// the counters of the first test run (kept by the thread which has run it) aren't carried over to
+// the second one - it has 3 passing asserts and succeeds
+static int run(int argc, char** argv, const char* filter) {
+    doctest::Context context(argc, argv);
+    context.addFilter("test-case", filter);
+    context.setOption("no-exitcode", false); // the exit codes are part of the output
+    const int res = context.run();
+    std::cout << "exit code: " << res << std::endl;
+    return res;
+}
+
+int main(int argc, char** argv) {
+    run(argc, argv, "*first*");
+    return run(argc, argv, "*second*");
+}
@@ -179,6 +179,47 @@ TEST_CASE("subcases with changing names") {
     }
 }
 
+TEST_CASE("subcases with names which hash the same") {
+    // "Aa" and "B@" have the same djb2 hash - both should be traversed
+    for(const char* name : {"Aa", "B@"}) {
+        SUBCASE(name) {
+            MESSAGE("traversed");
+        }
+    }
+}
+
+TEST_CASE("subcases traversed in parallel" * doctest::parallel_subcases()) {
+    for(int i = 0; i < 2; ++i) {
+        SUBCASE("outer " + std::to_string(i)) {
+            SUBCASE("check") {
+                CHECK(i == 0);
+            }
+            SUBCASE("message") {
+                MESSAGE(i);
+            }
+        }
+    }
+}
+
+TEST_CASE("setup shared by the passes through the subcases") {
+    static int computed = 0;
+    const std::vector<int>& data =
+            doctest::test_cache<std::vector<int>>("data", [] { return std::vector<int>(3, ++computed); });
+    // values of different types don't clash even when they are given the same name
+    const int& size = doctest::test_cache<int>("data", [&data] { return static_cast<int>(data.size()); });
+    ONCE_PER_TEST("setup") {
+        MESSAGE("expensive setup");
+    }
+    SUBCASE("first") {
+        CHECK(data.size() == 3);
+        CHECK(size == 3);
+    }
+    SUBCASE("second") {
+        CHECK(data.front() == 1);
+    }
+    CHECK(computed == 1);
+}
+
 TEST_SUITE("with a funny name,") {
     TEST_CASE("with a funnier name\\:") {
         SUBCASE("with the funniest name\\,") {
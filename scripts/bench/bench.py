@@ -36,6 +36,8 @@ parser_r = subparsers.add_parser('runtime', help='benchmark runtime')
 addCommonFlags(parser_r)
 parser_r.add_argument("--loop-iters",   type=int, default=1000, help = "loop N times all asserts in each test case")
 parser_r.add_argument("--info",         action = "store_true",  help = "log the loop variable with INFO()")
+parser_r.add_argument("--listener",     action = "store_true",  help = "<doctest> register a listener which wants passing asserts")
+parser_r.add_argument("--filter",       type=str, default="",  help = "<doctest> command line filters for the run - the tests are named test_<file>_<test> (-c measures just the startup)")
 
 def compile(args): args.compile = True; args.runtime = False
 def runtime(args): args.compile = False; args.runtime = True
@@ -118,7 +120,8 @@ for i in range(0, args.files):
         f.write(defines)
         f.write(include)
         for t in range(0, args.tests):
-            f.write('TEST_CASE("") {\n')
+            if args.filter: f.write('TEST_CASE("test_' + str(i) + '_' + str(t) + '") {\n')
+            else:           f.write('TEST_CASE("") {\n')
             f.write('    int a = 5;\n')
             f.write('    int b = 5;\n')
             if args.runtime and args.loop_iters > 0:
@@ -141,6 +144,24 @@ if args.runtime or args.implement or args.header:
     f.write(defines)
     f.write(define_implement)
     f.write(include)
+if args.runtime and args.listener and not args.catch:
+    # passing asserts can no longer take the fast path - they all go through the reporters
+    f.write('struct listener : doctest::IReporter {\n')
+    f.write('    listener(const doctest::ContextOptions&) {}\n')
+    f.write('    void report_query(const doctest::QueryData&) override {}\n')
+    f.write('    void test_run_start() override {}\n')
+    f.write('    void test_run_end(const doctest::TestRunStats&) override {}\n')
+    f.write('    void test_case_start(const doctest::TestCaseData&) override {}\n')
+    f.write('    void test_case_reenter(const doctest::TestCaseData&) override {}\n')
+    f.write('    void test_case_end(const doctest::CurrentTestCaseStats&) override {}\n')
+    f.write('    void test_case_exception(const doctest::TestCaseException&) override {}\n')
+    f.write('    void subcase_start(const doctest::SubcaseSignature&) override {}\n')
+    f.write('    void subcase_end() override {}\n')
+    f.write('    void log_assert(const doctest::AssertData&) override {}\n')
+    f.write('    void log_message(const doctest::MessageData&) override {}\n')
+    f.write('    void test_case_skipped(const doctest::TestCaseData&) override {}\n')
+    f.write('};\n')
+    f.write('REGISTER_LISTENER("listener", 1, listener);\n\n')
 f.write('int main(int argc, char** argv) {\n')
 if args.runtime or args.implement or args.header:
     if not args.catch:  f.write('    int res = doctest::Context(argc, argv).run();\n')
@@ -208,13 +229,14 @@ if not args.runtime:
 # ==============================================================================
 
 if args.runtime:
+    filters = (' "' + args.filter + '"') if args.filter and not args.catch else ''
     start = datetime.now()
     if args.compiler == 'msvc':
-        os.system(('Debug' if args.debug else 'Release') + '\\bench.exe')
+        os.system(('Debug' if args.debug else 'Release') + '\\bench.exe' + filters)
     elif os.name == "nt":
-        os.system('bench.exe')
+        os.system('bench.exe' + filters)
     else:
-        os.system('./bench')
+        os.system('./bench' + filters)
     end = datetime.now()
 
     print("Time running the tests in seconds: " + str((end - start).total_seconds()))